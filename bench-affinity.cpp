@@ -0,0 +1,104 @@
+#include "context-pool.hpp"
+#include "common-events.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+std::atomic<unsigned> halfway{0};
+
+class PingReactor: public Reactor {
+public:
+	explicit PingReactor(SelfPtr self, ActorPtr peer, unsigned count): _self(self), _peer(peer), _count(count), _half(count / 2) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				if(--_count == _half) {
+					halfway.fetch_add(1);
+				}
+				if(_count == 0) {
+					_peer->send(
+						Event::make<EvtExit>()
+					);
+					_self->reset();
+				} else {
+					_peer->send(event);
+				}
+				break;
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _peer;
+	unsigned _count;
+	unsigned _half;
+};
+
+enum {
+	NUM_CONTEXTS = 4,
+	NUM_PAIRS = 16,
+	NUM_ROUND_TRIPS = 20000,
+};
+
+struct Result {
+	double hop;
+	uint64_t cross;
+	ContextPool::Colocation colocation;
+};
+
+// profiles the first half of the round trips, optionally co-locates,
+// then measures the second half
+Result run(bool colocate) {
+	ContextPool pool(NUM_CONTEXTS);
+	pool.set_affinity_profile(true);
+	std::vector<ActorUV::SharedPtr> pings;
+	std::vector<ActorUV::SharedPtr> pongs;
+	for(unsigned i = 0; i < NUM_PAIRS; ++i) {
+		ActorUV::SharedPtr ping = pool.spawn();
+		ActorUV::SharedPtr pong = pool.spawn();
+		ping->reset(
+			Reactor::make<PingReactor>(ping, pong, NUM_ROUND_TRIPS)
+		);
+		pong->reset(
+			Reactor::make<PingReactor>(pong, ping, NUM_ROUND_TRIPS)
+		);
+		pings.push_back(ping);
+		pongs.push_back(pong);
+	}
+	halfway = 0;
+	for(auto& ping : pings) {
+		ping->send(
+			Event::make<EvtUpdate>()
+		);
+	}
+	Result result;
+	pool.exec();
+	while(halfway.load() < NUM_PAIRS) {
+		uv_sleep(1);
+	}
+	if(colocate) {
+		result.colocation = pool.colocate();
+	}
+	const uint64_t cross = pool.cross_sends();
+	const uint64_t ini = uv_hrtime();
+	pool.wait();
+	const uint64_t end = uv_hrtime();
+	result.hop = (double)(end - ini) / (double)NUM_ROUND_TRIPS;
+	result.cross = pool.cross_sends() - cross;
+	return result;
+}
+
+int main() {
+	const Result spread = run(false);
+	const Result colocated = run(true);
+	printf("%u ping-pong pairs on %u contexts, second half of %u round trips\n", (unsigned)NUM_PAIRS, (unsigned)NUM_CONTEXTS, (unsigned)NUM_ROUND_TRIPS);
+	printf("%10s %10.1f ns/round %12llu cross sends\n", "spread", spread.hop, (long long unsigned int)spread.cross);
+	printf("%10s %10.1f ns/round %12llu cross sends\n", "colocated", colocated.hop, (long long unsigned int)colocated.cross);
+	printf("colocate() moved %u actors, profiled sends saved %llu\n", (unsigned)colocated.colocation.moved, (long long unsigned int)colocated.colocation.saved);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <cstdio>
+
+enum {
+	NUM_EVENTS = 200000,
+	BURST = 1000,
+	CAPACITY = 2000,
+	WORK = 2000, // ns per event on the consumer
+	BUDGET = 64, // events per turn, leftovers must stay bounded
+};
+
+// odd samples can be lost, like unreliable packets
+class EvtSample: public EventType<0x3B6E0D51> {
+public:
+	explicit EvtSample(uint32_t _id): id(_id) {}
+	void dump(Writer& writer) const override {
+		writer.write_u32(id);
+	}
+	bool droppable() const noexcept override {
+		return (id & 1) != 0;
+	}
+	uint32_t id;
+};
+
+class ConsumerReactor: public Reactor {
+public:
+	explicit ConsumerReactor(SelfPtr self, uint64_t& delivered): _self(self), _delivered(delivered) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtSample::TYPE: {
+				const uint64_t ini = uv_hrtime();
+				while(uv_hrtime() - ini < WORK) {}
+				++_delivered;
+				break;
+			}
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	uint64_t& _delivered;
+};
+
+// sends a burst every millisecond, faster than the consumer keeps up
+// backs off for a few bursts when told the consumer hit its high water
+class ProducerReactor: public Reactor {
+public:
+	struct Stats {
+		uint64_t refused = 0;
+		uint64_t high_water = 0;
+		size_t max_depth = 0;
+	};
+	explicit ProducerReactor(SelfPtr self, ActorPtr consumer, Stats& stats): _self(self), _consumer(consumer), _stats(stats) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				if(_pause > 0) {
+					--_pause;
+				} else {
+					burst();
+				}
+				if(_sent < NUM_EVENTS) {
+					_self->send(
+						Event::make<EvtUpdate>(),
+						1000
+					);
+				} else {
+					// delayed sends are not bounded
+					_consumer->send(
+						Event::make<EvtExit>(),
+						1000
+					);
+					_self->reset();
+				}
+				break;
+			case EvtHighWater::TYPE:
+				++_stats.high_water;
+				_pause = 4;
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	void burst() {
+		for(unsigned i = 0; i < BURST && _sent < NUM_EVENTS; ++i) {
+			if(!_consumer->send(Event::make<EvtSample>(_sent++))) {
+				++_stats.refused;
+			}
+		}
+		const size_t depth = _consumer->depth();
+		if(depth > _stats.max_depth) {
+			_stats.max_depth = depth;
+		}
+	}
+	SelfPtr _self;
+	ActorPtr _consumer;
+	Stats& _stats;
+	unsigned _pause = 0;
+	uint32_t _sent = 0;
+};
+
+void run(const char* name, size_t capacity, Queue::Policy policy, size_t budget = 0) {
+	ContextUV producer_context;
+	ContextUV consumer_context;
+	ActorUV::SharedPtr producer = producer_context.spawn();
+	ActorUV::SharedPtr consumer = consumer_context.spawn();
+	uint64_t delivered = 0;
+	ProducerReactor::Stats stats;
+	consumer->set_capacity(capacity, policy);
+	consumer->set_event_budget(budget);
+	consumer->reset(
+		Reactor::make<ConsumerReactor>(consumer, delivered)
+	);
+	producer->reset(
+		Reactor::make<ProducerReactor>(producer, consumer, stats)
+	);
+	producer->send(
+		Event::make<EvtUpdate>()
+	);
+	const uint64_t ini = uv_hrtime();
+	producer_context.exec();
+	consumer_context.exec();
+	producer_context.wait();
+	consumer_context.wait();
+	const uint64_t end = uv_hrtime();
+	printf("%14s %8llu delivered %8llu refused %8llu dropped %8llu max depth %4llu high water %6.0f ms\n",
+		name,
+		(long long unsigned int)delivered,
+		(long long unsigned int)stats.refused,
+		(long long unsigned int)consumer->dropped(),
+		(long long unsigned int)stats.max_depth,
+		(long long unsigned int)stats.high_water,
+		(end - ini) / 1e6
+	);
+}
+
+int main() {
+	printf("%u events in bursts of %u per ms, %u ns of work each, capacity %u\n", (unsigned)NUM_EVENTS, (unsigned)BURST, (unsigned)WORK, (unsigned)CAPACITY);
+	run("unbounded", 0, Queue::REJECT);
+	run("reject", CAPACITY, Queue::REJECT);
+	run("reject, budget", CAPACITY, Queue::REJECT, BUDGET);
+	run("drop oldest", CAPACITY, Queue::DROP_OLDEST);
+	run("drop droppable", CAPACITY, Queue::DROP_DROPPABLE);
+	run("high water", CAPACITY, Queue::HIGH_WATER);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "typed-reactor.hpp"
+#include "uv.hpp"
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <cstdio>
+
+enum : uint32_t {
+	NUM_TYPES = 64,
+	NUM_EVENTS = 1 << 16,
+	NUM_ROUNDS = 100,
+};
+
+// scattered ids, like the hand-picked EventType<0x...> constants
+template<uint32_t N>
+class EvtBench: public InlineEventType<(N + 1) * 2654435761u, EvtBench<N>> {
+public:
+	void dump(Writer& writer) const override {}
+};
+
+template<uint32_t... Is>
+struct Indices {};
+template<uint32_t N, uint32_t... Is>
+struct MakeIndices: MakeIndices<N - 1, N - 1, Is...> {};
+template<uint32_t... Is>
+struct MakeIndices<0, Is...> {
+	using type = Indices<Is...>;
+};
+
+template<typename>
+class TypedBench;
+template<uint32_t... Is>
+class TypedBench<Indices<Is...>>: public TypedReactor<TypedBench<Indices<Is...>>, EvtBench<Is>...> {
+	friend typename TypedBench::Typed;
+public:
+	void dump(Writer& writer) const override {}
+	uint64_t sum = 0;
+private:
+	template<uint32_t N>
+	void on(const EvtBench<N>& event, uint64_t timestamp) {
+		sum += N;
+	}
+};
+using TypedReactorBench = TypedBench<MakeIndices<NUM_TYPES>::type>;
+
+#define CASE(n) \
+	case EvtBench<n>::TYPE: \
+		on(event->as<EvtBench<n>>()); \
+		break;
+#define CASE8(n) CASE(n) CASE(n + 1) CASE(n + 2) CASE(n + 3) CASE(n + 4) CASE(n + 5) CASE(n + 6) CASE(n + 7)
+
+// what the reactors wrote by hand so far
+class SwitchBench: public Reactor {
+public:
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			CASE8(0) CASE8(8) CASE8(16) CASE8(24) CASE8(32) CASE8(40) CASE8(48) CASE8(56)
+			default:
+				break;
+		}
+	}
+	uint64_t sum = 0;
+private:
+	template<uint32_t N>
+	void on(const EvtBench<N>& event) {
+		sum += N;
+	}
+};
+
+// runtime registry, the usual alternative
+class MapBench: public Reactor {
+	using Handler = void(*)(MapBench&, const Event&);
+public:
+	MapBench() {
+		add(MakeIndices<NUM_TYPES>::type());
+	}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		auto itr = _handlers.find(event->type);
+		if(itr != _handlers.end()) {
+			itr->second(*this, *event);
+		}
+	}
+	uint64_t sum = 0;
+private:
+	template<uint32_t N>
+	static void on(MapBench& self, const Event& event) {
+		self.sum += N;
+	}
+	template<uint32_t... Is>
+	void add(Indices<Is...>) {
+		const int expand[] = { (_handlers[EvtBench<Is>::TYPE] = &MapBench::on<Is>, 0)... };
+		(void)expand;
+	}
+	std::unordered_map<uint32_t, Handler> _handlers;
+};
+
+template<uint32_t... Is>
+std::vector<Event::SharedPtr> make_events(Indices<Is...>) {
+	const std::vector<Event::SharedPtr> types = { Event::make<EvtBench<Is>>()... };
+	std::vector<Event::SharedPtr> events;
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<uint32_t> dist(0, NUM_TYPES - 1);
+	for(uint32_t i = 0; i < NUM_EVENTS; ++i) {
+		events.push_back(types[dist(rng)]);
+	}
+	return events;
+}
+
+template<typename T>
+double run(const char* name, const std::vector<Event::SharedPtr>& events) {
+	T reactor;
+	Reactor& base = reactor;
+	const uint64_t ini = uv_hrtime();
+	for(uint32_t round = 0; round < NUM_ROUNDS; ++round) {
+		for(const Event::SharedPtr& event : events) {
+			base.react(event, round);
+		}
+	}
+	const uint64_t end = uv_hrtime();
+	const double ns = (double)(end - ini) / ((double)NUM_ROUNDS * events.size());
+	printf("%10s %10.2f ns/event (sum %llu)\n", name, ns, (long long unsigned int)reactor.sum);
+	return ns;
+}
+
+int main() {
+	const std::vector<Event::SharedPtr> events = make_events(MakeIndices<NUM_TYPES>::type());
+	printf("dispatch over %u event types, %u events\n", (unsigned)NUM_TYPES, (unsigned)(NUM_ROUNDS * events.size()));
+	run<SwitchBench>("switch", events);
+	run<MapBench>("map", events);
+	run<TypedReactorBench>("typed", events);
+	return 0;
+}
\ No newline at end of file
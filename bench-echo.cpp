@@ -0,0 +1,160 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+#include "network-events.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+// counts every heap allocation of the process
+static std::atomic<uint64_t> num_allocations(0);
+
+// out of line, so the compiler never pairs the inlined malloc and free
+__attribute__((noinline)) void* operator new(size_t size) {
+	num_allocations.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = malloc(size);
+	if(ptr == nullptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+// same traffic as EchoReactor in test-enet, without the sockets
+class EchoReactor: public Reactor {
+public:
+	explicit EchoReactor(SelfPtr self, std::vector<ActorPtr>& clients, ActorPtr logger): _self(self), _clients(clients), _logger(logger) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtReceived::TYPE:
+				on_received(event->as<EvtReceived>(), timestamp);
+				break;
+			case EvtExit::TYPE:
+				if(++_exited == _clients.size()) {
+					_self->reset();
+				}
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	void on_received(const EvtReceived& event, uint64_t timestamp) {
+		_logger->send(
+			Event::make<EvtLog>("[S] received src=%u size=%u t=%llu"_log, event.src, (unsigned)event.data.size(), (long long unsigned int)timestamp)
+		);
+		_clients[event.src]->send(
+			Event::make<EvtReceived>(event.src, std::string(event.data))
+		);
+	}
+	SelfPtr _self;
+	std::vector<ActorPtr>& _clients;
+	ActorPtr _logger;
+	size_t _exited = 0;
+};
+
+class ClientReactor: public Reactor {
+public:
+	explicit ClientReactor(SelfPtr self, uint16_t id, ActorPtr server, ActorPtr logger, unsigned count): _self(self), _id(id), _server(server), _logger(logger), _count(count) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+			case EvtReceived::TYPE:
+				_logger->send(
+					Event::make<EvtLog>("[C] update t=%llu"_log, (long long unsigned int)timestamp)
+				);
+				if(_count-- == 0) {
+					_server->send(
+						Event::make<EvtExit>()
+					);
+					_self->reset();
+				} else {
+					uint64_t t = timestamp;
+					_server->send(
+						Event::make<EvtReceived>(_id, std::string(reinterpret_cast<const char*>(&t), sizeof(t)))
+					);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	uint16_t _id;
+	ActorPtr _server;
+	ActorPtr _logger;
+	unsigned _count;
+};
+
+class CountReactor: public Reactor {
+public:
+	explicit CountReactor(SelfPtr self, unsigned expected): _self(self), _expected(expected) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		if(event->type == EvtLog::TYPE && ++_received == _expected) {
+			_self->reset();
+		}
+	}
+private:
+	SelfPtr _self;
+	unsigned _expected;
+	unsigned _received = 0;
+};
+
+enum {
+	NUM_THREADS = 4,
+	NUM_CLIENTS = 8,
+	NUM_ROUND_TRIPS = 50000,
+};
+
+int main() {
+	std::vector<ContextUV> contexts(NUM_THREADS);
+	unsigned idx = 0;
+	ActorUV::SharedPtr logger = contexts[(idx++) % NUM_THREADS].spawn();
+	ActorUV::SharedPtr server = contexts[(idx++) % NUM_THREADS].spawn();
+	std::vector<Actor::SharedPtr> clients;
+	const unsigned num_logs = NUM_CLIENTS * (NUM_ROUND_TRIPS * 2 + 1);
+	logger->reset(
+		Reactor::make<CountReactor>(logger, num_logs)
+	);
+	for(unsigned i = 0; i < NUM_CLIENTS; ++i) {
+		ActorUV::SharedPtr client = contexts[(idx++) % NUM_THREADS].spawn();
+		client->reset(
+			Reactor::make<ClientReactor>(client, i, server, logger, NUM_ROUND_TRIPS)
+		);
+		clients.push_back(client);
+	}
+	server->reset(
+		Reactor::make<EchoReactor>(server, clients, logger)
+	);
+	for(auto& client : clients) {
+		client->send(
+			Event::make<EvtUpdate>()
+		);
+	}
+	const uint64_t ini_allocations = num_allocations.load();
+	const uint64_t ini = uv_hrtime();
+	for(auto& ctx : contexts) {
+		ctx.exec();
+	}
+	for(auto& ctx : contexts) {
+		ctx.wait();
+	}
+	const uint64_t end = uv_hrtime();
+	const uint64_t allocations = num_allocations.load() - ini_allocations;
+	const double events = (double)NUM_CLIENTS * NUM_ROUND_TRIPS * 4;
+#ifdef EVENT_NO_POOL
+	printf("echo workload, global heap\n");
+#else
+	printf("echo workload, event pool\n");
+#endif
+	printf("events       %.0f\n", events);
+	printf("allocations  %.2f per event\n", allocations / events);
+	printf("throughput   %.0f events/s\n", events * 1e9 / (end - ini));
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+
+enum {
+	TICK_PERIOD = 1,
+	NUM_TICKS = 2000,
+	BURST_PERIOD = 100,
+	BURST_SIZE = 10000,
+	WORK_NS = 2000,
+};
+
+class EvtTick: public EventType<0x6B1D7E30> {
+public:
+	explicit EvtTick(uint64_t _due): due(_due) {}
+	void dump(Writer& writer) const override {
+		writer.write_u64(due);
+	}
+	uint64_t due;
+};
+
+// light actor measuring how late its periodic ticks are delivered
+class LightReactor: public Reactor {
+public:
+	explicit LightReactor(SelfPtr self, std::vector<ActorPtr> peers, std::vector<uint64_t>& late): _self(self), _peers(peers), _late(late) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtTick::TYPE: {
+				const uint64_t now = uv_hrtime();
+				const uint64_t due = event->as<EvtTick>().due;
+				_late.push_back(now > due ? now - due : 0);
+				if(_late.size() < NUM_TICKS) {
+					tick();
+				} else {
+					for(auto& peer : _peers) {
+						peer->send(
+							Event::make<EvtExit>()
+						);
+					}
+					_self->reset();
+				}
+				break;
+			}
+			case EvtUpdate::TYPE:
+				tick();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	void tick() {
+		_self->send(
+			Event::make<EvtTick>(uv_hrtime() + TICK_PERIOD * 1000000ull),
+			TICK_PERIOD * 1000
+		);
+	}
+	SelfPtr _self;
+	std::vector<ActorPtr> _peers;
+	std::vector<uint64_t>& _late;
+};
+
+// flooded actor, every event costs WORK_NS of cpu
+class FloodReactor: public Reactor {
+public:
+	explicit FloodReactor(SelfPtr self): _self(self) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE: {
+				const uint64_t end = uv_hrtime() + WORK_NS;
+				while(uv_hrtime() < end) {
+				}
+				break;
+			}
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+};
+
+// sends a burst of work to the flooded actor every BURST_PERIOD
+class BurstReactor: public Reactor {
+public:
+	explicit BurstReactor(SelfPtr self, ActorPtr target): _self(self), _target(target) {
+		for(unsigned i = 0; i < BURST_SIZE; ++i) {
+			_burst.emplace_back(Event::make<EvtUpdate>(), 0);
+		}
+	}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				_target->send_batch(_burst);
+				_self->send(event, BURST_PERIOD * 1000);
+				break;
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _target;
+	std::vector<Actor::EventDelay> _burst;
+};
+
+void run(const char* name, size_t max_events, uint64_t max_time) {
+	ContextUV context;
+	ActorUV::SharedPtr light = context.spawn();
+	ActorUV::SharedPtr flood = context.spawn();
+	ActorUV::SharedPtr burst = context.spawn();
+	std::vector<uint64_t> late;
+	flood->set_event_budget(max_events);
+	flood->set_time_budget(max_time);
+	flood->reset(
+		Reactor::make<FloodReactor>(flood)
+	);
+	burst->reset(
+		Reactor::make<BurstReactor>(burst, flood)
+	);
+	light->reset(
+		Reactor::make<LightReactor>(light, std::vector<Actor::SharedPtr>{flood, burst}, late)
+	);
+	light->send(
+		Event::make<EvtUpdate>()
+	);
+	burst->send(
+		Event::make<EvtUpdate>()
+	);
+	context.exec();
+	context.wait();
+	std::sort(late.begin(), late.end());
+	const auto at = [&late](double q) {
+		return (double)late[(size_t)(q * (late.size() - 1))] / 1e6;
+	};
+	printf("%16s %10.2f %10.2f %10.2f ms\n", name, at(0.5), at(0.99), at(1.0));
+}
+
+int main() {
+	printf("light actor tick lateness next to a flooded one (%u x %u us every %u ms)\n", (unsigned)BURST_SIZE, (unsigned)(WORK_NS / 1000), (unsigned)BURST_PERIOD);
+	printf("%16s %10s %10s %10s\n", "budget", "p50", "p99", "max");
+	run("none", 0, 0);
+	run("256 events", 256, 0);
+	run("500 us", 0, 500000);
+	return 0;
+}
\ No newline at end of file
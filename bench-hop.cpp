@@ -0,0 +1,95 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <cstdio>
+
+enum {
+	NUM_HOPS = 20000,
+	SPIN_WINDOW = 50,
+};
+
+class EvtStamp: public EventType<0x2E94C05B> {
+public:
+	explicit EvtStamp(uint64_t _sent): sent(_sent) {}
+	void dump(Writer& writer) const override {
+		writer.write_u64(sent);
+	}
+	uint64_t sent;
+};
+
+// bounces a stamp with its peer, recording how long each hop took
+class HopReactor: public Reactor {
+public:
+	explicit HopReactor(SelfPtr self, ActorPtr peer, std::vector<uint64_t>& hops): _self(self), _peer(peer), _hops(hops) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtStamp::TYPE: {
+				const uint64_t now = uv_hrtime();
+				_hops.push_back(now - event->as<EvtStamp>().sent);
+				if(_hops.size() < NUM_HOPS) {
+					_peer->send(
+						Event::make<EvtStamp>(uv_hrtime())
+					);
+				} else {
+					_peer->send(
+						Event::make<EvtExit>()
+					);
+					_self->reset();
+				}
+				break;
+			}
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _peer;
+	std::vector<uint64_t>& _hops;
+};
+
+void run(const char* name, uint32_t window) {
+	ContextUV first;
+	ContextUV second;
+	first.set_busy_poll(window);
+	second.set_busy_poll(window);
+	ActorUV::SharedPtr ping = first.spawn();
+	ActorUV::SharedPtr pong = second.spawn();
+	std::vector<uint64_t> hops;
+	hops.reserve(2 * NUM_HOPS);
+	std::vector<uint64_t> pong_hops;
+	pong_hops.reserve(NUM_HOPS);
+	ping->reset(
+		Reactor::make<HopReactor>(ping, pong, hops)
+	);
+	pong->reset(
+		Reactor::make<HopReactor>(pong, ping, pong_hops)
+	);
+	ping->send(
+		Event::make<EvtStamp>(uv_hrtime())
+	);
+	first.exec();
+	second.exec();
+	first.wait();
+	second.wait();
+	hops.insert(hops.end(), pong_hops.begin(), pong_hops.end());
+	std::sort(hops.begin(), hops.end());
+	const auto at = [&hops](double q) {
+		return (double)hops[(size_t)(q * (hops.size() - 1))] / 1e3;
+	};
+	printf("%16s %10.2f %10.2f %10.2f %10.2f us\n", name, at(0.5), at(0.9), at(0.99), at(0.999));
+}
+
+int main() {
+	printf("cross-context hop latency, %u hops each way\n", (unsigned)NUM_HOPS);
+	printf("%16s %10s %10s %10s %10s\n", "mode", "p50", "p90", "p99", "p99.9");
+	run("default", 0);
+	run("busy-poll 50us", SPIN_WINDOW);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <cstdio>
+
+class PingReactor: public Reactor {
+public:
+	explicit PingReactor(SelfPtr self, ActorPtr peer, unsigned count): _self(self), _peer(peer), _count(count) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				if(--_count == 0) {
+					_peer->send(
+						Event::make<EvtExit>()
+					);
+					_self->reset();
+				} else {
+					_peer->send(event);
+				}
+				break;
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _peer;
+	unsigned _count;
+};
+
+enum {
+	NUM_ROUND_TRIPS = 200000,
+};
+
+double run(bool direct) {
+	ContextUV context;
+	ActorUV::SharedPtr ping = context.spawn();
+	ActorUV::SharedPtr pong = context.spawn();
+	ping->set_direct_dispatch(direct);
+	pong->set_direct_dispatch(direct);
+	ping->reset(
+		Reactor::make<PingReactor>(ping, pong, NUM_ROUND_TRIPS)
+	);
+	pong->reset(
+		Reactor::make<PingReactor>(pong, ping, NUM_ROUND_TRIPS)
+	);
+	ping->send(
+		Event::make<EvtUpdate>()
+	);
+	const uint64_t ini = uv_hrtime();
+	context.exec();
+	context.wait();
+	const uint64_t end = uv_hrtime();
+	return (double)(end - ini) / (2.0 * NUM_ROUND_TRIPS);
+}
+
+int main() {
+	const double mailbox = run(false);
+	const double direct = run(true);
+	printf("same-loop ping-pong, %u round trips\n", (unsigned)NUM_ROUND_TRIPS);
+	printf("%10s %10.1f ns/hop\n", "mailbox", mailbox);
+	printf("%10s %10.1f ns/hop\n", "direct", direct);
+	return 0;
+}
\ No newline at end of file
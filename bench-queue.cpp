@@ -0,0 +1,90 @@
+#include "queue.hpp"
+#include "uv.hpp"
+
+#include <thread>
+#include <cstdio>
+
+// ready path of the previous Queue, kept here as the baseline
+class MutexQueue {
+public:
+	using EventPtr = Event::SharedPtr;
+	using EventPair = std::pair<EventPtr, uint64_t>;
+	using EventVector = std::vector<EventPair>;
+	void set_open(bool value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_open = value;
+	}
+	bool add_ready(EventPtr&& event, uint64_t timestamp) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(_open) {
+			_ready.emplace_back(std::move(event), timestamp);
+		}
+		return _open;
+	}
+	void get_events(EventVector& out) {
+		out.clear();
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::swap(out, _ready);
+	}
+private:
+	std::mutex _mutex;
+	EventVector _ready;
+	bool _open = false;
+};
+
+enum {
+	NUM_EVENTS = 1000000,
+	NUM_ROUNDS = 3,
+};
+
+template<typename Q>
+double run(unsigned producers) {
+	Q queue;
+	queue.set_open(true);
+	const unsigned per_producer = NUM_EVENTS / producers;
+	const unsigned total = per_producer * producers;
+	std::vector<std::thread> threads;
+	std::atomic<bool> go(false);
+	for(unsigned p = 0; p < producers; ++p) {
+		threads.emplace_back([&queue, &go, per_producer]() {
+			while(!go.load(std::memory_order_acquire)) {}
+			for(unsigned i = 0; i < per_producer; ++i) {
+				queue.add_ready(Event::SharedPtr(), i);
+			}
+		});
+	}
+	typename Q::EventVector events;
+	unsigned received = 0;
+	const uint64_t ini = uv_hrtime();
+	go.store(true, std::memory_order_release);
+	while(received < total) {
+		queue.get_events(events);
+		received += events.size();
+	}
+	const uint64_t end = uv_hrtime();
+	for(auto& thread : threads) {
+		thread.join();
+	}
+	return (double)total * 1000.0 / (double)(end - ini);
+}
+
+template<typename Q>
+double best(unsigned producers) {
+	double result = 0;
+	for(unsigned r = 0; r < NUM_ROUNDS; ++r) {
+		double value = run<Q>(producers);
+		if(value > result) {
+			result = value;
+		}
+	}
+	return result;
+}
+
+int main() {
+	printf("%9s %14s %14s\n", "producers", "mutex Mev/s", "lock-free Mev/s");
+	const unsigned counts[] = {1, 2, 4, 8, 16};
+	for(unsigned producers : counts) {
+		printf("%9u %14.2f %14.2f\n", producers, best<MutexQueue>(producers), best<Queue>(producers));
+	}
+	return 0;
+}
\ No newline at end of file
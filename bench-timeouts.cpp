@@ -0,0 +1,157 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <cstdio>
+
+enum {
+	NUM_REQUESTS = 200000,
+	WINDOW = 100,
+	TIMEOUT = 1000,
+};
+
+class EvtRequest: public EventType<0x71C3A90E> {
+public:
+	explicit EvtRequest(uint32_t _id): id(_id) {}
+	void dump(Writer& writer) const override {
+		writer.write_u32(id);
+	}
+	uint32_t id;
+};
+
+class EvtReply: public EventType<0x71C3A90F> {
+public:
+	explicit EvtReply(uint32_t _id): id(_id) {}
+	void dump(Writer& writer) const override {
+		writer.write_u32(id);
+	}
+	uint32_t id;
+};
+
+class EvtTimeout: public EventType<0x71C3A910> {
+public:
+	explicit EvtTimeout(uint32_t _id): id(_id) {}
+	void dump(Writer& writer) const override {
+		writer.write_u32(id);
+	}
+	uint32_t id;
+};
+
+class ServerReactor: public Reactor {
+public:
+	explicit ServerReactor(SelfPtr self, ActorPtr client): _self(self), _client(client) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtRequest::TYPE:
+				_client->send(
+					Event::make<EvtReply>(event->as<EvtRequest>().id)
+				);
+				break;
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _client;
+};
+
+// keeps WINDOW requests in flight, each guarded by a timeout that
+// is either cancelled on reply or left to expire and be ignored
+class ClientReactor: public Reactor {
+public:
+	explicit ClientReactor(SelfPtr self, ActorPtr server, bool cancel, uint64_t& expired): _self(self), _server(server), _cancel(cancel), _expired(expired), _timeouts(NUM_REQUESTS) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				for(unsigned i = 0; i < WINDOW; ++i) {
+					request();
+				}
+				break;
+			case EvtReply::TYPE: {
+				const uint32_t id = event->as<EvtReply>().id;
+				if(_cancel) {
+					_timeouts[id].cancel();
+				}
+				if(++_replies == NUM_REQUESTS) {
+					finish();
+				} else if(_sent < NUM_REQUESTS) {
+					request();
+				}
+				break;
+			}
+			case EvtTimeout::TYPE:
+				++_expired; // answered long ago, ignored
+				if(_expired + _replies == 2 * NUM_REQUESTS) {
+					_self->reset();
+				}
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	void request() {
+		const uint32_t id = _sent++;
+		_server->send(
+			Event::make<EvtRequest>(id)
+		);
+		_timeouts[id] = _self->send(
+			Event::make<EvtTimeout>(id),
+			TIMEOUT * 1000
+		);
+	}
+	void finish() {
+		_server->send(
+			Event::make<EvtExit>()
+		);
+		if(_cancel) {
+			_self->reset();
+		}
+	}
+	SelfPtr _self;
+	ActorPtr _server;
+	const bool _cancel;
+	uint64_t& _expired;
+	std::vector<Actor::Token> _timeouts;
+	uint32_t _sent = 0;
+	uint32_t _replies = 0;
+};
+
+void run(const char* name, bool cancel) {
+	ContextUV client_context;
+	ContextUV server_context;
+	ActorUV::SharedPtr client = client_context.spawn();
+	ActorUV::SharedPtr server = server_context.spawn();
+	uint64_t expired = 0;
+	server->reset(
+		Reactor::make<ServerReactor>(server, client)
+	);
+	client->reset(
+		Reactor::make<ClientReactor>(client, server, cancel, expired)
+	);
+	client->send(
+		Event::make<EvtUpdate>()
+	);
+	uv_rusage_t ini_usage, end_usage;
+	UV_INVOKE(uv_getrusage(&ini_usage));
+	client_context.exec();
+	server_context.exec();
+	client_context.wait();
+	server_context.wait();
+	UV_INVOKE(uv_getrusage(&end_usage));
+	const double cpu = (end_usage.ru_utime.tv_sec - ini_usage.ru_utime.tv_sec) + (end_usage.ru_stime.tv_sec - ini_usage.ru_stime.tv_sec)
+		+ ((end_usage.ru_utime.tv_usec - ini_usage.ru_utime.tv_usec) + (end_usage.ru_stime.tv_usec - ini_usage.ru_stime.tv_usec)) / 1e6;
+	printf("%10s %10.0f ns/request %10llu timeouts delivered\n", name, cpu * 1e9 / NUM_REQUESTS, (long long unsigned int)expired);
+}
+
+int main() {
+	printf("%u requests, %u in flight, each with a %u ms timeout\n", (unsigned)NUM_REQUESTS, (unsigned)WINDOW, (unsigned)TIMEOUT);
+	run("ignore", false);
+	run("cancel", true);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "context-uv.hpp"
+#include "common-events.hpp"
+
+#include <random>
+#include <cstdio>
+
+struct TickStats {
+	uint64_t ticks = 0;
+	uint64_t late_total = 0;
+	uint64_t late_max = 0;
+};
+
+class TickReactor: public Reactor {
+public:
+	explicit TickReactor(ActorUV::SharedPtr self, TickStats& stats, uint32_t period, uint64_t end, bool periodic): _self(self), _stats(stats), _period(period), _end(end), _periodic(periodic) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				on_tick(timestamp);
+				if(timestamp + _period >= _end) {
+					_self->reset();
+				} else if(!_periodic) {
+					_self->send(event, _period);
+				} else if(!_started) {
+					_self->send_every(event, _period);
+					_started = true;
+				}
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	void on_tick(uint64_t timestamp) {
+		const uint64_t late = _self->timestamp() - timestamp;
+		_stats.ticks += 1;
+		_stats.late_total += late;
+		if(late > _stats.late_max) {
+			_stats.late_max = late;
+		}
+	}
+	ActorUV::SharedPtr _self;
+	TickStats& _stats;
+	uint32_t _period;
+	uint64_t _end;
+	bool _periodic;
+	bool _started = false;
+};
+
+// times in microseconds
+enum {
+	NUM_ACTORS = 100000,
+	MIN_PERIOD = 50000,
+	MAX_PERIOD = 1000000,
+	DURATION = 5000000,
+	NUM_PRECISE_ACTORS = 100,
+	MIN_PRECISE_PERIOD = 100,
+	MAX_PRECISE_PERIOD = 500,
+	PRECISE_DURATION = 2000000,
+};
+
+void run(LoopUV::Clock clock, bool periodic, unsigned num_actors, uint32_t min_period, uint32_t max_period, uint64_t duration) {
+	const char* resolution = clock == LoopUV::MICROSECONDS ? "us" : "ms";
+	ContextUV context(clock);
+	TickStats stats;
+	std::mt19937 random(num_actors);
+	std::uniform_int_distribution<uint32_t> period(min_period, max_period);
+	for(unsigned i = 0; i < num_actors; ++i) {
+		ActorUV::SharedPtr actor = context.spawn();
+		const uint32_t p = period(random);
+		actor->reset(
+			Reactor::make<TickReactor>(actor, stats, p, duration, periodic)
+		);
+		actor->send(
+			Event::make<EvtUpdate>(),
+			random() % p + 1
+		);
+	}
+	uv_rusage_t ini_usage, end_usage;
+	UV_INVOKE(uv_getrusage(&ini_usage));
+	const uint64_t ini = uv_hrtime();
+	context.exec();
+	context.wait();
+	const uint64_t end = uv_hrtime();
+	UV_INVOKE(uv_getrusage(&end_usage));
+	const double wall = (double)(end - ini) / 1e9;
+	const double cpu = (end_usage.ru_utime.tv_sec - ini_usage.ru_utime.tv_sec) + (end_usage.ru_stime.tv_sec - ini_usage.ru_stime.tv_sec)
+		+ ((end_usage.ru_utime.tv_usec - ini_usage.ru_utime.tv_usec) + (end_usage.ru_stime.tv_usec - ini_usage.ru_stime.tv_usec)) / 1e6;
+	printf("%u periodic actors on one context, %s clock, periods %u..%u us, %s\n", num_actors, resolution, (unsigned)min_period, (unsigned)max_period, periodic ? "send_every" : "delayed send");
+	printf("ticks      %llu (%.0f/s)\n", (long long unsigned int)stats.ticks, stats.ticks / wall);
+	printf("cpu        %.2f s of %.2f s wall (%.0f ns/tick)\n", cpu, wall, cpu * 1e9 / stats.ticks);
+	printf("lateness   avg %.2f us, max %llu us\n", (double)stats.late_total / stats.ticks, (long long unsigned int)stats.late_max);
+}
+
+int main() {
+	run(LoopUV::MILLISECONDS, false, NUM_ACTORS, MIN_PERIOD, MAX_PERIOD, DURATION);
+	run(LoopUV::MILLISECONDS, true, NUM_ACTORS, MIN_PERIOD, MAX_PERIOD, DURATION);
+	run(LoopUV::MICROSECONDS, true, NUM_PRECISE_ACTORS, MIN_PRECISE_PERIOD, MAX_PRECISE_PERIOD, PRECISE_DURATION);
+	return 0;
+}
\ No newline at end of file
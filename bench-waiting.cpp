@@ -0,0 +1,100 @@
+#include "queue.hpp"
+#include "uv.hpp"
+
+#include <list>
+#include <random>
+#include <cstdio>
+
+// delayed path of the previous Queue, kept here as the baseline
+class ListQueue {
+public:
+	using EventPtr = Event::SharedPtr;
+	using EventPair = std::pair<EventPtr, uint64_t>;
+	using EventVector = std::vector<EventPair>;
+	void set_open(bool value) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_open = value;
+	}
+	bool add_waiting(EventPtr&& event, uint64_t timestamp) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(!_open) {
+			return false;
+		}
+		if(_waiting.empty() || timestamp < _waiting.front().second) {
+			_waiting.emplace_front(std::move(event), timestamp);
+			return true;
+		} else {
+			auto itr = _waiting.begin();
+			do {
+				++itr;
+			} while(itr != _waiting.end() && timestamp >= itr->second);
+			_waiting.emplace(itr, std::move(event), timestamp);
+			return false;
+		}
+	}
+	uint64_t update(uint64_t timestamp) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		while(!_waiting.empty() && timestamp >= _waiting.front().second) {
+			_ready.emplace_back(std::move(_waiting.front().first), _waiting.front().second);
+			_waiting.pop_front();
+		}
+		return _waiting.empty() ? 0 : _waiting.front().second;
+	}
+	void get_events(EventVector& out) {
+		out.clear();
+		std::swap(out, _ready);
+	}
+private:
+	std::mutex _mutex;
+	EventVector _ready;
+	std::list<EventPair> _waiting;
+	bool _open = false;
+};
+
+enum {
+	MAX_DELAY = 60000,
+	TICK = 10,
+	LIST_LIMIT = 50000, // the list is quadratic, larger sizes take minutes
+};
+
+// fills the queue with n random deadlines then drains it tick by tick
+template<typename Q>
+void run(unsigned n, double& insert_ns, double& drain_ns) {
+	Q queue;
+	queue.set_open(true);
+	std::mt19937 random(n);
+	std::uniform_int_distribution<uint32_t> delay(1, MAX_DELAY);
+	uint64_t ini = uv_hrtime();
+	for(unsigned i = 0; i < n; ++i) {
+		queue.add_waiting(Event::SharedPtr(), delay(random));
+	}
+	uint64_t mid = uv_hrtime();
+	typename Q::EventVector events;
+	unsigned received = 0;
+	for(uint64_t t = 0; received < n; t += TICK) {
+		queue.update(t);
+		queue.get_events(events);
+		received += events.size();
+	}
+	uint64_t end = uv_hrtime();
+	insert_ns = (double)(mid - ini) / n;
+	drain_ns = (double)(end - mid) / n;
+}
+
+int main() {
+	printf("%9s %16s %16s %16s %16s\n", "events", "list add ns", "list drain ns", "heap add ns", "heap drain ns");
+	const unsigned counts[] = {10000, 50000, 100000, 1000000};
+	for(unsigned n : counts) {
+		double list_insert = 0, list_drain = 0, heap_insert, heap_drain;
+		if(n <= LIST_LIMIT) {
+			run<ListQueue>(n, list_insert, list_drain);
+		}
+		run<Queue>(n, heap_insert, heap_drain);
+		if(n <= LIST_LIMIT) {
+			printf("%9u %16.1f %16.1f %16.1f %16.1f\n", n, list_insert, list_drain, heap_insert, heap_drain);
+		} else {
+			printf("%9u %16s %16s %16.1f %16.1f\n", n, "-", "-", heap_insert, heap_drain);
+		}
+	}
+	return 0;
+}
\ No newline at end of file
@@ -1,26 +1,302 @@
 #ifndef COMMON_EVENTS_HPP
 #define COMMON_EVENTS_HPP
 
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
 #include "event.hpp"
 
-class EvtExit: public EventType<0x4F09D95F> {
+class EvtExit: public InlineEventType<0x4F09D95F, EvtExit> {
 public:
 	virtual void dump(Writer& writer) const override {}
 };
 
-class EvtUpdate: public EventType<0x2E5FAF24> {
+class EvtUpdate: public InlineEventType<0x2E5FAF24, EvtUpdate> {
 public:
 	virtual void dump(Writer& writer) const override {}
 };
 
+// asks a buffering reactor to write its pending output
+class EvtFlush: public InlineEventType<0x5A3C81D2, EvtFlush> {
+public:
+	virtual void dump(Writer& writer) const override {}
+};
+
+// captures the format and a binary copy of its arguments, formatted by the receiver
+// format is kept by pointer, so it can only be a string literal with the
+// _log suffix, e.g. Event::make<EvtLog>("%i items"_log, count)
+// supports integers, floating point, strings and pointers, not '*' width or precision
 class EvtLog: public EventType<0x34ABEFEF> {
+	enum : uint8_t {
+		ARG_INT,
+		ARG_UINT,
+		ARG_DOUBLE,
+		ARG_STRING,
+		ARG_POINTER,
+	};
 public:
+	enum : size_t {
+		ARGS_SIZE = 88,
+	};
+	// only made by the _log literal operator
+	class Format {
+		friend Format operator"" _log(const char* text, size_t size) noexcept;
+	public:
+		const char* const text;
+	private:
+		explicit Format(const char* _text) noexcept: text(_text) {}
+	};
 	template<typename... Ts>
-	explicit EvtLog(Ts&&... ts) {
-		snprintf(text, sizeof(text), std::forward<Ts>(ts)...);
+	explicit EvtLog(Format _format, const Ts&... ts): format(_format.text) {
+		const int expand[] = { 0, (put(ts), 0)... };
+		(void)expand;
 	}
-	virtual void dump(Writer& writer) const override {}
-	char text[256];
+	// each argument as its tag and typed value, pointers as their tag only
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(format);
+		writer.write_u8(_count);
+		size_t pos = 0;
+		while(pos < _size) {
+			const uint8_t tag = static_cast<uint8_t>(_args[pos++]);
+			writer.write_u8(tag);
+			switch(tag) {
+				case ARG_INT:
+					writer.write_i64(get<int64_t>(pos));
+					break;
+				case ARG_UINT:
+					writer.write_u64(get<uint64_t>(pos));
+					break;
+				case ARG_DOUBLE:
+					writer.write_f64(get<double>(pos));
+					break;
+				case ARG_STRING: {
+					const uint16_t size = get<uint16_t>(pos);
+					writer.write_bytes(&_args[pos], size);
+					pos += size + 1;
+					break;
+				}
+				case ARG_POINTER:
+					// an address means nothing to the reader
+					pos += sizeof(const void*);
+					break;
+				default:
+					return;
+			}
+		}
+		writer.write_bool(_truncated);
+	}
+	// appends the formatted text to out
+	void print(std::string& out) const {
+		size_t pos = 0;
+		const char* itr = format;
+		while(*itr != '\0') {
+			if(*itr != '%') {
+				const char* end = strchr(itr, '%');
+				if(end == nullptr) {
+					end = itr + strlen(itr);
+				}
+				out.append(itr, end);
+				itr = end;
+				continue;
+			}
+			if(itr[1] == '%') {
+				out.push_back('%');
+				itr += 2;
+				continue;
+			}
+			// conversion spec without length modifier, e.g. "%-8.3"
+			char spec[32];
+			size_t len = 0;
+			spec[len++] = *itr++;
+			while(*itr != '\0' && strchr("-+ #0123456789.*hlLqjzt", *itr) != nullptr) {
+				if(strchr("*hlLqjzt", *itr) == nullptr && len < sizeof(spec) - 4) {
+					spec[len++] = *itr;
+				}
+				++itr;
+			}
+			if(*itr == '\0') {
+				break;
+			}
+			const char conv = *itr++;
+			if(pos >= _size) {
+				if(!_truncated) {
+					out.append("(?)");
+				}
+				continue;
+			}
+			const uint8_t tag = static_cast<uint8_t>(_args[pos++]);
+			int64_t i = 0;
+			uint64_t u = 0;
+			double d = 0.0;
+			const char* str = "(?)";
+			const void* ptr = nullptr;
+			switch(tag) {
+				case ARG_INT:
+					i = get<int64_t>(pos);
+					u = static_cast<uint64_t>(i);
+					d = static_cast<double>(i);
+					break;
+				case ARG_UINT:
+					u = get<uint64_t>(pos);
+					i = static_cast<int64_t>(u);
+					d = static_cast<double>(u);
+					break;
+				case ARG_DOUBLE:
+					d = get<double>(pos);
+					i = static_cast<int64_t>(d);
+					u = static_cast<uint64_t>(i);
+					break;
+				case ARG_STRING: {
+					const uint16_t size = get<uint16_t>(pos);
+					str = &_args[pos];
+					pos += size + 1;
+					break;
+				}
+				case ARG_POINTER:
+					ptr = get<const void*>(pos);
+					break;
+				default:
+					return;
+			}
+			switch(conv) {
+				case 'd':
+				case 'i':
+					append(out, spec, len, "ll", conv, static_cast<long long>(i));
+					break;
+				case 'u':
+				case 'o':
+				case 'x':
+				case 'X':
+					append(out, spec, len, "ll", conv, static_cast<unsigned long long>(u));
+					break;
+				case 'c':
+					append(out, spec, len, "", conv, static_cast<int>(i));
+					break;
+				case 'e':
+				case 'E':
+				case 'f':
+				case 'F':
+				case 'g':
+				case 'G':
+				case 'a':
+				case 'A':
+					append(out, spec, len, "", conv, d);
+					break;
+				case 's':
+					append(out, spec, len, "", conv, str);
+					break;
+				case 'p':
+					append(out, spec, len, "", conv, ptr);
+					break;
+				default:
+					break;
+			}
+		}
+		if(_truncated) {
+			out.append("...");
+		}
+	}
+	const char* const format;
+private:
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type put(T value) noexcept {
+		put_value(ARG_INT, static_cast<int64_t>(value));
+	}
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type put(T value) noexcept {
+		put_value(ARG_UINT, static_cast<uint64_t>(value));
+	}
+	template<typename T>
+	typename std::enable_if<std::is_enum<T>::value>::type put(T value) noexcept {
+		put_value(ARG_INT, static_cast<int64_t>(value));
+	}
+	template<typename T>
+	typename std::enable_if<std::is_floating_point<T>::value>::type put(T value) noexcept {
+		put_value(ARG_DOUBLE, static_cast<double>(value));
+	}
+	template<typename T>
+	void put(const T* value) noexcept {
+		put_value(ARG_POINTER, static_cast<const void*>(value));
+	}
+	void put(const char* value) noexcept {
+		if(value == nullptr) {
+			value = "(null)";
+		}
+		put_string(value, strlen(value));
+	}
+	void put(const std::string& value) noexcept {
+		put_string(value.data(), value.size());
+	}
+	template<typename T>
+	void put_value(uint8_t tag, T value) noexcept {
+		if(_truncated || _size + 1 + sizeof(T) > ARGS_SIZE) {
+			_truncated = true;
+			return;
+		}
+		_args[_size++] = static_cast<char>(tag);
+		memcpy(&_args[_size], &value, sizeof(T));
+		_size += sizeof(T);
+		++_count;
+	}
+	// stored null-terminated, cut to the remaining space
+	void put_string(const char* value, size_t size) noexcept {
+		const size_t header = 1 + sizeof(uint16_t);
+		if(_truncated || _size + header + 1 > ARGS_SIZE) {
+			_truncated = true;
+			return;
+		}
+		if(_size + header + size + 1 > ARGS_SIZE) {
+			size = ARGS_SIZE - _size - header - 1;
+			_truncated = true;
+		}
+		const uint16_t length = static_cast<uint16_t>(size);
+		_args[_size++] = static_cast<char>(ARG_STRING);
+		memcpy(&_args[_size], &length, sizeof(length));
+		_size += sizeof(length);
+		memcpy(&_args[_size], value, size);
+		_size += size;
+		_args[_size++] = '\0';
+		++_count;
+	}
+	template<typename T>
+	T get(size_t& pos) const noexcept {
+		T value;
+		memcpy(&value, &_args[pos], sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+	template<typename T>
+	static void append(std::string& out, char* spec, size_t len, const char* length, char conv, T value) {
+		size_t end = len;
+		while(*length != '\0') {
+			spec[end++] = *length++;
+		}
+		spec[end++] = conv;
+		spec[end] = '\0';
+		char buffer[64];
+		const int size = snprintf(buffer, sizeof(buffer), spec, value);
+		if(size < 0) {
+			return;
+		}
+		if(static_cast<size_t>(size) < sizeof(buffer)) {
+			out.append(buffer, size);
+		} else {
+			const size_t offset = out.size();
+			out.resize(offset + size + 1);
+			snprintf(&out[offset], size + 1, spec, value);
+			out.resize(offset + size);
+		}
+	}
+
+	uint16_t _size = 0;
+	uint8_t _count = 0;
+	bool _truncated = false;
+	char _args[ARGS_SIZE];
 };
 
+inline EvtLog::Format operator"" _log(const char* text, size_t size) noexcept {
+	return EvtLog::Format(text);
+}
+
 #endif
\ No newline at end of file
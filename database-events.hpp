@@ -7,7 +7,10 @@
 class EvtPut: public EventType<0x15040EFE> {
 public:
 	explicit EvtPut(std::string&& _key, std::string&& _value): key(std::move(_key)), value(std::move(_value)) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(key);
+		writer.write_string(value);
+	}
 	std::string key;
 	std::string value;
 };
@@ -15,14 +18,19 @@ public:
 class EvtGet: public EventType<0x46AFA95A> {
 public:
 	explicit EvtGet(std::string&& _key): key(std::move(_key)) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(key);
+	}
 	std::string key;
 };
 
 class EvtResult: public EventType<0xA5105B4F> {
 public:
 	explicit EvtResult(std::string&& _key, std::string&& _value): key(std::move(_key)), value(std::move(_value)) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(key);
+		writer.write_string(value);
+	}
 	std::string key;
 	std::string value;
 };
@@ -5,7 +5,7 @@
 
 class ENetReactorAuto: public ENetReactor {
 	enum {
-		UPDATE_TIME = 50,
+		UPDATE_TIME = 50000, // us
 	};
 public:
 	using ENetReactor::ENetReactor;
@@ -17,9 +17,10 @@ public:
 				_self->send(
 					Event::make<EvtUpdate>()
 				);
-				break;
-			case EvtUpdate::TYPE:
-				_self->send(event, UPDATE_TIME);
+				_self->send_every(
+					Event::make<EvtUpdate>(),
+					UPDATE_TIME
+				);
 				break;
 			default:
 				break;
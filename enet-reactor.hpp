@@ -5,7 +5,7 @@
 #include <exception>
 #include <utility>
 #include <cstdio>
-#include "reactor.hpp"
+#include "typed-reactor.hpp"
 #include "common-events.hpp"
 #include "network-events.hpp"
 
@@ -22,7 +22,8 @@ private:
 	char _buf[256];
 };
 
-class ENetReactor: public Reactor {
+class ENetReactor: public TypedReactor<ENetReactor, EvtListen, EvtConnect, EvtSend, EvtKick, EvtUpdate, EvtExit> {
+	friend Typed;
 	class Library {
 	public:
 		static Library& require() {
@@ -60,32 +61,16 @@ public:
 		Library::require();
 	}
 	void dump(Writer& writer) const override {}
-	void react(const EventPtr& event, uint64_t timestamp) override {
-		switch(event->type) {
-			case EvtListen::TYPE:
-				on_listen(event->as<EvtListen>(), timestamp);
-				break;
-			case EvtConnect::TYPE:
-				on_connect(event->as<EvtConnect>(), timestamp);
-				break;
-			case EvtSend::TYPE:
-				on_send(event->as<EvtSend>(), timestamp);
-				break;
-			case EvtKick::TYPE:
-				on_kick(event->as<EvtKick>(), timestamp);
-				break;
-			case EvtUpdate::TYPE:
-				on_update(event->as<EvtUpdate>(), timestamp);
-				break;
-			case EvtExit::TYPE:
-				_self->reset();
-				break;
-			default:
-				break;
+	// packets queued by the batch leave in a single flush
+	void react_batch(Batch& batch) override {
+		_sent = false;
+		Reactor::react_batch(batch); // can throw
+		if(_sent && _enet_host) {
+			enet_host_flush(_enet_host.get());
 		}
 	}
 protected:
-	void on_listen(const EvtListen& event, uint32_t timestamp) {
+	void on(const EvtListen& event, uint64_t timestamp) {
 		if(_enet_host) {
 			throw ENetException("can't listen: enet host already initialized");
 		}
@@ -105,7 +90,7 @@ protected:
 			throw ENetException("can't listen: can't create enet host");
 		}
 	}
-	void on_connect(const EvtConnect& event, uint32_t timestamp) {
+	void on(const EvtConnect& event, uint64_t timestamp) {
 		if(_enet_host) {
 			throw ENetException("can't connect: enet host already initialized");
 		}
@@ -126,7 +111,7 @@ protected:
 			throw ENetException("can't connect: failed to connect peer");
 		}
 	}
-	void on_send(const EvtSend& event, uint32_t timestamp) {
+	void on(const EvtSend& event, uint64_t timestamp) {
 		if(!_enet_host) {
 			throw ENetException("can't send: enet host not initialized");
 		}
@@ -142,8 +127,9 @@ protected:
 			throw ENetException("can't send: can't send packet to peer");
 		}
 		packet.release();
+		_sent = true;
 	}
-	void on_kick(const EvtKick& event, uint32_t timestamp) {
+	void on(const EvtKick& event, uint64_t timestamp) {
 		if(!_enet_host) {
 			throw ENetException("can't kick: enet host not initialized");
 		}
@@ -152,9 +138,12 @@ protected:
 		}
 		enet_peer_disconnect_later(&_enet_host->peers[event.dst], 0);
 	}
-	void on_update(const EvtUpdate& event, uint32_t timestamp) {
+	void on(const EvtUpdate& event, uint64_t timestamp) {
 		update();
 	}
+	void on(const EvtExit& event, uint64_t timestamp) {
+		_self->reset();
+	}
 	void update() {
 		if(!_enet_host) {
 			throw ENetException("can't update: enet host not initialized");
@@ -168,12 +157,12 @@ protected:
 			switch(enet_event.type) {
 				case ENET_EVENT_TYPE_CONNECT:
 					_observer->send(
-						std::make_shared<EvtConnected>(id)
+						Event::make<EvtConnected>(id)
 					);
 					break;
 				case ENET_EVENT_TYPE_DISCONNECT:
 					_observer->send(
-						std::make_shared<EvtDisconnected>(id)
+						Event::make<EvtDisconnected>(id)
 					);
 					break;
 				case ENET_EVENT_TYPE_RECEIVE:
@@ -182,7 +171,7 @@ protected:
 					}
 					data = std::string(reinterpret_cast<const char*>(packet->data), packet->dataLength);
 					_observer->send(
-						std::make_shared<EvtReceived>(id, std::move(data))
+						Event::make<EvtReceived>(id, std::move(data))
 					);
 					break;
 				default:
@@ -197,6 +186,7 @@ protected:
 	SelfPtr _self;
 	ActorPtr _observer;
 	HostPtr _enet_host;
+	bool _sent = false;
 };
 
 #endif
\ No newline at end of file
@@ -5,7 +5,9 @@
 
 class FakeActor: public Actor {
 public:
-	void send(EventPtr event, uint32_t delay) override {}
+	Token send(EventPtr event, uint64_t delay) override {
+		return Token();
+	}
 };
 
 #endif
\ No newline at end of file
@@ -2,8 +2,10 @@
 #define ACTOR_UV_HPP
 
 #include "uv.hpp"
+#include "loop-uv.hpp"
 #include "actor.hpp"
 #include "queue.hpp"
+#include "outbox.hpp"
 #include "stateful.hpp"
 
 #define LOG_DEBUG(...) /*{\
@@ -12,47 +14,125 @@
 	printf("\n");\
 }*/
 
-class ActorUV: public ActorSelf, public std::enable_shared_from_this<ActorUV> {
+class ActorUV: public ActorSelf, public LoopUV::Task, public std::enable_shared_from_this<ActorUV> {
 	using ReactorPtr = ActorSelf::ReactorPtr;
 	using EventPtr = Event::SharedPtr;
+	using EventDelay = Actor::EventDelay;
 	using EventPair = std::pair<EventPtr, uint64_t>;
 	using EventVector = std::vector<EventPair>;
+	enum {
+		MAX_DIRECT_ROUNDS = 64,
+		TIME_SLICE = 16,
+		AFFINITY_PEERS = 8,
+	};
+	// same-loop sends of the running callback, delivered before returning to the loop
+	struct Direct {
+		LoopUV* loop = nullptr;
+		ActorUV* self = nullptr; // reacting actor
+		std::vector<std::pair<std::shared_ptr<ActorUV>, EventPair>> pending;
+	};
+	static Direct& direct() noexcept {
+		static thread_local Direct local;
+		return local;
+	}
 public:
 	using SharedPtr = std::shared_ptr<ActorUV>;
-	explicit ActorUV(std::shared_ptr<uv_loop_t> loop): _loop(std::move(loop)) {
+	using Affinity = std::vector<std::pair<const ActorUV*, uint64_t>>;
+	explicit ActorUV(LoopUV::SharedPtr loop): LoopUV::Task(loop.get()), _loop(std::move(loop)) {
 		LOG_DEBUG("ActorUV::ActorUV() [%p]", this);
-		_ini_time = uv_now(_loop.get());
+		_ini_time = _loop->now();
 	}
 	~ActorUV() noexcept {
 		LOG_DEBUG("ActorUV::~ActorUV() [%p]", this);
 	}
+	// not thread-safe: use only in this thread-loop
+	// pins the actor to its current loop, so handles created on it stay valid
 	std::shared_ptr<uv_loop_t> loop() {
-		return _loop;
+		pin();
+		return std::shared_ptr<uv_loop_t>(_loop, home()->raw());
 	}
+	// microseconds since construction, at the resolution of the loop clock
 	uint64_t timestamp() const noexcept {
-		return static_cast<uint64_t>(uv_now(_loop.get()) - _ini_time);
+		return home()->now() - _ini_time;
 	}
 	uint64_t reactive_time() const noexcept override {
 		return static_cast<uint64_t>(_react_time_total / 1000000);
 	}
 	// thread-safe
-	void send(EventPtr event, uint32_t delay = 0) override {
+	// delayed sends skip the outbox, so their token can cancel them right away
+	// so do sends to a bounded actor, so their token tells if admitted
+	Token send(EventPtr event, uint64_t delay = 0) override {
 		LOG_DEBUG("ActorUV::send() type=%u [%p]", event->type, this);
+		Direct& local = direct();
+		if(delay == 0 && local.loop == home() && _direct_enabled) {
+			LOG_DEBUG("\tadd direct");
+			if(local.loop->grouped()) {
+				// held by two actors that may end up on different threads
+				event->share();
+			}
+			profile(local, 1);
+			local.pending.emplace_back(shared_from_this(), EventPair(std::move(event), timestamp()));
+			return Token(true);
+		}
+		event->share();
 		uint64_t t = timestamp() + delay;
 		if(delay > 0) {
 			LOG_DEBUG("\tadd waiting timestamp=%llu", (long long unsigned int)t);
-			if(_queue.add_waiting(std::move(event), t)) {
+			profile(local, 1);
+			Queue::Handle handle;
+			if(_queue.add_waiting(std::move(event), t, &handle)) {
 				notify();
 			}
-		} else {
-			LOG_DEBUG("\tadd ready timestamp=%llu", (long long unsigned int)t);
-			if(_queue.add_ready(std::move(event), t)) {
-				notify();
+			if(handle.generation == 0) {
+				return Token();
+			}
+			return Token(shared_from_this(), handle.slot, handle.generation);
+		}
+		Outbox* outbox = Outbox::current();
+		if(outbox != nullptr && _queue.capacity() == 0) {
+			LOG_DEBUG("\tadd outbox");
+			outbox->add(shared_from_this(), std::move(event), delay);
+			return Token(true);
+		}
+		profile(local, 1);
+		LOG_DEBUG("\tadd ready timestamp=%llu", (long long unsigned int)t);
+		const unsigned result = _queue.add_ready(std::move(event), t);
+		if(result & Queue::FIRST) {
+			notify();
+		}
+		if(result & Queue::HIGH_WATER_REACHED) {
+			high_water(local);
+		}
+		return Token((result & Queue::ACCEPTED) != 0);
+	}
+	// thread-safe
+	// single enqueue and at most one wakeup for the whole batch
+	using Actor::send_batch;
+	void send_batch(const EventDelay* begin, const EventDelay* end) override {
+		LOG_DEBUG("ActorUV::send_batch() size=%u [%p]", (unsigned)(end - begin), this);
+		if(_queue.capacity() > 0) {
+			Actor::send_batch(begin, end);
+			return;
+		}
+		Outbox* outbox = Outbox::current();
+		if(outbox != nullptr) {
+			for(; begin != end; ++begin) {
+				outbox->add(shared_from_this(), EventPtr(begin->first), begin->second);
 			}
+			return;
+		}
+		for(const EventDelay* it = begin; it != end; ++it) {
+			it->first->share();
+		}
+		profile(direct(), end - begin);
+		if(_queue.add_batch(begin, end, timestamp()) & Queue::FIRST) {
+			notify();
 		}
 	}
-	void reset(ReactorPtr&& state) override {
+	void reset(ReactorPtr&& state = ReactorPtr()) override {
 		LOG_DEBUG("ActorUV::reset() [%p]", this);
+		_periodic.clear();
+		++_periodic_generation;
 		bool was_running = _stateful.is_running();
 		_stateful.set(std::move(state));
 		if(!was_running && _stateful.is_running()) {
@@ -64,85 +144,350 @@ public:
 			on_stop();
 		}
 	}
-	ActorSelf::SharedPtr spawn() override {
-		LOG_DEBUG("ActorUV::spawn() [%p]", this);
-		return std::make_shared<ActorUV>(_loop);
-	}
-private:
-	static void async_callback(uv_async_t* handle) {
-		LOG_DEBUG("ActorUV::async_callback() handle: %p", handle);
-		if(handle->data != nullptr) {
-			(*reinterpret_cast<SharedPtr*>(handle->data))->on_trigger();
+	// not thread-safe: use only in this thread-loop
+	// ticks are kept out of the mailbox, a tick late by several periods is
+	// delivered once, at the time it was due; ignored unless running
+	void send_every(EventPtr event, uint64_t period) override {
+		LOG_DEBUG("ActorUV::send_every() type=%u period=%llu [%p]", event->type, (long long unsigned int)period, this);
+		if(period == 0 || !_stateful.is_running()) {
+			return;
 		}
+		const uint64_t next = timestamp() + period;
+		_periodic.push_back(Periodic{std::move(event), period, next});
+		home()->arm_before(*this, _ini_time + next);
 	}
-	static void timer_callback(uv_timer_t* handle) {
-		LOG_DEBUG("ActorUV::timer_callback() handle: %p", handle);
-		if(handle->data != nullptr) {
-			(*reinterpret_cast<SharedPtr*>(handle->data))->on_trigger();
-		}
+	// not thread-safe: use only in this thread-loop
+	// when enabled, sends made while reacting are buffered per destination
+	// and flushed once the reaction batch is over
+	void set_outbox(bool enabled) noexcept {
+		_outbox_enabled = enabled;
 	}
-	static void close_callback(uv_handle_t* handle) {
-		LOG_DEBUG("ActorUV::close_callback() handle: %p", handle);
-		if(handle->data != nullptr) {
-			SharedPtr* shared = reinterpret_cast<SharedPtr*>(handle->data);
-			handle->data = nullptr;
-			delete shared;
+	// not thread-safe: use only in this thread-loop
+	// when enabled (default), sends from reactions running on the same loop
+	// skip the mailbox and are delivered before the loop regains control
+	void set_direct_dispatch(bool enabled) noexcept {
+		_direct_enabled = enabled;
+	}
+	// not thread-safe: use only in this thread-loop
+	// caps a turn at max_events events, 0 for no limit
+	// the rest waits for the next turn, after the other runnable actors of the loop
+	void set_event_budget(size_t max_events) noexcept {
+		_max_events = max_events;
+	}
+	// not thread-safe: use only in this thread-loop
+	// caps a turn at about max_time nanoseconds of reactions, 0 for no limit
+	// checked every TIME_SLICE events
+	void set_time_budget(uint64_t max_time) noexcept {
+		_max_time = max_time;
+	}
+	// not thread-safe: use only in this thread-loop
+	// bounds the events sent from other loops (or by delay) waiting in the
+	// mailbox, 0 (default) for no limit, see Queue::Policy for the overflow
+	// same-loop direct sends are never bounded
+	void set_capacity(size_t capacity, Queue::Policy policy = Queue::REJECT) noexcept {
+		_queue.set_capacity(capacity, policy);
+	}
+	// thread-safe
+	size_t depth() const noexcept override {
+		return _queue.depth();
+	}
+	// thread-safe
+	// events refused or dropped by the capacity so far
+	uint64_t dropped() const noexcept {
+		return _queue.dropped();
+	}
+	// not thread-safe: use only in this thread-loop
+	// when enabled, counts the sends of this actor per receiver
+	// only the AFFINITY_PEERS heaviest receivers are kept, counts are approximate
+	void set_affinity_profile(bool enabled) noexcept {
+		_profile = enabled;
+	}
+	// thread-safe
+	// profiled receivers of this actor and their send counts
+	void affinity(Affinity& out) const {
+		for(const Peer& peer : _peers) {
+			const ActorUV* actor = peer.actor.load(std::memory_order_acquire);
+			if(actor != nullptr) {
+				out.emplace_back(actor, peer.count.load(std::memory_order_relaxed));
+			}
 		}
 	}
+	// thread-safe
+	// profiled sends to an actor reacting in another loop
+	uint64_t cross_sends() const noexcept {
+		return _cross_sends.load(std::memory_order_relaxed);
+	}
+	ActorSelf::SharedPtr spawn() override {
+		LOG_DEBUG("ActorUV::spawn() [%p]", this);
+		// on the current home, the loop may have changed since construction
+		return std::make_shared<ActorUV>(LoopUV::SharedPtr(_loop, home()));
+	}
+private:
+	// a running actor is kept alive by itself until stopped
 	void on_start() {
 		LOG_DEBUG("ActorUV::on_start() [%p]", this);
-		UV_INVOKE(uv_async_init(_loop.get(), &_async, async_callback));
-		UV_INVOKE(uv_timer_init(_loop.get(), &_timer));
-		_async.data = new SharedPtr(this->shared_from_this());
-		_timer.data = new SharedPtr(this->shared_from_this());
+		_alive = shared_from_this();
+		home()->retain();
 		_queue.set_open(true);
 	}
 	void on_stop() {
 		LOG_DEBUG("ActorUV::on_stop() [%p]", this);
 		_queue.set_open(false);
-		uv_close(reinterpret_cast<uv_handle_t*>(&_async), close_callback);
-		uv_close(reinterpret_cast<uv_handle_t*>(&_timer), close_callback);
+		home()->disarm(*this);
+		home()->release();
+		_alive.reset();
+	}
+	// tells the reacting actor, if any, that its send filled this mailbox
+	void high_water(Direct& local) {
+		if(local.self != nullptr) {
+			local.self->send(Event::make<EvtHighWater>(shared_from_this(), depth()));
+		}
 	}
 	// thread-safe
+	// marks the actor runnable in its loop
 	void notify() {
 		LOG_DEBUG("ActorUV::notify() [%p]", this);
-		UV_INVOKE(uv_async_send(&_async));
+		home()->schedule(shared_from_this());
+	}
+	// counts sends of the reacting actor to this one, buffered sends once flushed
+	void profile(Direct& local, uint64_t count) noexcept {
+		if(local.self != nullptr && local.self->_profile) {
+			local.self->record(this, count);
+		}
+	}
+	// space-saving count: an unknown receiver replaces the lightest one
+	void record(const ActorUV* receiver, uint64_t count) noexcept {
+		if(receiver->home() != home()) {
+			_cross_sends.store(_cross_sends.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+		}
+		Peer* lightest = &_peers[0];
+		for(Peer& peer : _peers) {
+			const ActorUV* actor = peer.actor.load(std::memory_order_relaxed);
+			if(actor == receiver) {
+				peer.count.store(peer.count.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+				return;
+			}
+			if(actor == nullptr) {
+				lightest = &peer;
+				break;
+			}
+			if(peer.count.load(std::memory_order_relaxed) < lightest->count.load(std::memory_order_relaxed)) {
+				lightest = &peer;
+			}
+		}
+		lightest->count.store(lightest->count.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+		lightest->actor.store(receiver, std::memory_order_release);
+	}
+	bool cancel(uint32_t slot, uint32_t generation) override {
+		Queue::Handle handle;
+		handle.slot = slot;
+		handle.generation = generation;
+		return _queue.cancel(handle);
+	}
+	std::shared_ptr<LoopUV::Task> shared_task() override {
+		return shared_from_this();
+	}
+	void run() override {
+		LOG_DEBUG("ActorUV::run() [%p]", this);
+		if(_stateful.is_running()) {
+			on_trigger();
+		}
 	}
 	void on_trigger() {
 		LOG_DEBUG("ActorUV::on_trigger() [%p]", this);
-		const uint32_t cur_timestamp = timestamp();
-		const uint32_t next_timestamp = _queue.update(cur_timestamp);
+		Direct& local = direct();
+		local.loop = home();
+		local.self = this;
+		try {
+			on_update();
+			trigger_profile();
+			local.self = nullptr;
+			drain(local);
+		} catch(...) {
+			local.pending.clear();
+			local.loop = nullptr;
+			local.self = nullptr;
+			throw;
+		}
+		local.loop = nullptr;
+	}
+	// delivers the same-loop sends, one trigger per target and round
+	// so no reactor is ever re-entered
+	static void drain(Direct& local) {
+		std::vector<std::pair<SharedPtr, EventPair>> batch;
+		for(unsigned round = 0; !local.pending.empty(); ++round) {
+			batch.clear();
+			std::swap(batch, local.pending);
+			if(round >= MAX_DIRECT_ROUNDS) {
+				LOG_DEBUG("\tdirect fallback size=%u", (unsigned)batch.size());
+				for(auto& pair : batch) {
+					if(pair.first->_queue.add_ready(std::move(pair.second.first), pair.second.second) & Queue::FIRST) {
+						pair.first->notify();
+					}
+				}
+				continue;
+			}
+			for(auto& pair : batch) {
+				pair.first->_direct.emplace_back(std::move(pair.second));
+			}
+			for(auto& pair : batch) {
+				ActorUV& target = *pair.first;
+				if(!target._direct.empty() && target._stateful.is_running()) {
+					local.self = &target;
+					target.on_update();
+					target.trigger_profile();
+					local.self = nullptr;
+				}
+				target._direct.clear();
+			}
+		}
+	}
+	// moves due delayed events to ready, collects due ticks and arms the next deadline
+	void on_update() {
+		const uint64_t cur_timestamp = timestamp();
+		uint64_t next_timestamp = _queue.update(cur_timestamp);
+		for(Periodic& periodic : _periodic) {
+			if(periodic.next <= cur_timestamp) {
+				_ticks.emplace_back(periodic.event, periodic.next);
+				const uint64_t missed = (cur_timestamp - periodic.next) / periodic.period;
+				periodic.next += (missed + 1) * periodic.period;
+			}
+			if(next_timestamp == 0 || periodic.next < next_timestamp) {
+				next_timestamp = periodic.next;
+			}
+		}
 		if(next_timestamp > cur_timestamp) {
-			const uint32_t delay = next_timestamp - cur_timestamp;
-			LOG_DEBUG("\ttimer start delay=%u", delay);
-			UV_INVOKE(uv_timer_start(&_timer, timer_callback, delay, 0));
+			LOG_DEBUG("\ttimer arm delay=%llu", (long long unsigned int)(next_timestamp - cur_timestamp));
+			home()->arm(*this, _ini_time + next_timestamp);
 		} else {
-			LOG_DEBUG("\ttimer stop");
-			UV_INVOKE(uv_timer_stop(&_timer));
+			LOG_DEBUG("\ttimer disarm");
+			home()->disarm(*this);
 		}
-		trigger_profile();
 	}
+	// events left over by the budget of the previous turn go first, and the
+	// mailbox is not taken until they are delivered, so a bounded mailbox
+	// keeps counting what waits behind them
+	// leftovers stay in place past _consumed, the delivered ones are only
+	// erased once they are at least half of the vector
 	void trigger_profile() {
 		LOG_DEBUG("ActorUV::trigger_profile() [%p]", this);
-		_queue.get_events(_reacting);
+		const bool leftover = !_reacting.empty();
+		if(!leftover) {
+			_queue.get_events(_reacting);
+		} else if(_consumed >= _reacting.size() - _consumed) {
+			_reacting.erase(_reacting.begin(), _reacting.begin() + _consumed);
+			_consumed = 0;
+		}
+		for(auto& pair : _direct) {
+			_reacting.emplace_back(std::move(pair));
+		}
+		_direct.clear();
 		const uint64_t react_time_start = uv_hrtime();
-		_stateful.trigger(_reacting);
+		size_t done = 0;
+		if(_outbox_enabled) {
+			try {
+				Outbox::Scope scope(_outbox);
+				done = trigger_budget(react_time_start);
+			} catch(...) {
+				_outbox.flush();
+				throw;
+			}
+		} else {
+			done = trigger_budget(react_time_start);
+		}
 		const uint64_t react_time_final = uv_hrtime();
-		if(react_time_final >= react_time_start) {
-			_react_time_total += react_time_final - react_time_start;
+		const uint64_t react_time = react_time_final >= react_time_start ?
+			react_time_final - react_time_start :
+			(UINT64_MAX - react_time_start) + react_time_final;
+		_react_time_total += react_time;
+		home()->account(react_time);
+		_outbox.flush();
+		if(_consumed + done < _reacting.size() && _stateful.is_running()) {
+			LOG_DEBUG("\tbudget left=%u", (unsigned)(_reacting.size() - _consumed - done));
+			for(size_t i = 0; i < done; ++i) {
+				_reacting[_consumed + i].first.reset();
+			}
+			_consumed += done;
+			home()->yield(shared_from_this());
 		} else {
-			_react_time_total += (UINT64_MAX - react_time_start) + react_time_final;
+			_reacting.clear();
+			_consumed = 0;
+			if(leftover && _stateful.is_running()) {
+				// the mailbox was left untaken, and does not notify while not empty
+				home()->yield(shared_from_this());
+			}
 		}
 	}
+	// one trigger per tick, so none reaches the reactor set by a reset()
+	void trigger_ticks() {
+		const uint64_t generation = _periodic_generation;
+		try {
+			for(size_t i = 0; i < _ticks.size() && generation == _periodic_generation; ++i) {
+				_stateful.trigger(&_ticks[i], &_ticks[i] + 1);
+			}
+		} catch(...) {
+			_ticks.clear();
+			throw;
+		}
+		_ticks.clear();
+	}
+	// delivers the ticks and the events of this turn within the budget
+	// returns how many events were delivered
+	size_t trigger_budget(uint64_t start) {
+		if(!_ticks.empty()) {
+			trigger_ticks();
+		}
+		const EventPair* begin = _reacting.data() + _consumed;
+		size_t size = _reacting.size() - _consumed;
+		if(_max_events > 0 && size > _max_events) {
+			size = _max_events;
+		}
+		if(_max_time == 0) {
+			_stateful.trigger(begin, begin + size);
+			return size;
+		}
+		size_t done = 0;
+		while(done < size && _stateful.is_running()) {
+			const size_t slice = size - done < TIME_SLICE ? size - done : TIME_SLICE;
+			_stateful.trigger(begin + done, begin + done + slice);
+			done += slice;
+			if(uv_hrtime() - start >= _max_time) {
+				break;
+			}
+		}
+		return done;
+	}
+	
+	struct Periodic {
+		EventPtr event;
+		uint64_t period;
+		uint64_t next;
+	};
+	struct Peer {
+		std::atomic<const ActorUV*> actor{nullptr};
+		std::atomic<uint64_t> count{0};
+	};
 	
 	Queue _queue;
 	Stateful _stateful;
 	EventVector _reacting;
-	std::shared_ptr<uv_loop_t> _loop;
-	uv_async_t _async;
-	uv_timer_t _timer;
+	size_t _consumed = 0; // delivered events at the front of _reacting
+	EventVector _direct;
+	EventVector _ticks;
+	std::vector<Periodic> _periodic;
+	uint64_t _periodic_generation = 0;
+	Outbox _outbox;
+	LoopUV::SharedPtr _loop; // keeps the loop, or the group of loops, alive
+	SharedPtr _alive;
 	uint64_t _react_time_total = 0;
 	uint64_t _ini_time = 0;
+	size_t _max_events = 0;
+	uint64_t _max_time = 0;
+	Peer _peers[AFFINITY_PEERS];
+	std::atomic<uint64_t> _cross_sends{0};
+	bool _profile = false;
+	bool _outbox_enabled = false;
+	bool _direct_enabled = true;
 };
 
 #endif
\ No newline at end of file
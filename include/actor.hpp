@@ -1,6 +1,10 @@
 #ifndef ACTOR_HPP
 #define ACTOR_HPP
 
+#include <memory>
+#include <vector>
+#include <utility>
+#include <initializer_list>
 #include "event.hpp"
 
 class Reactor;
@@ -9,10 +13,73 @@ class Reactor;
 class Actor {
 public:
 	using EventPtr = Event::SharedPtr;
+	using EventDelay = std::pair<EventPtr, uint64_t>;
 	using SharedPtr = std::shared_ptr<Actor>;
 	
+	// result of a send, false when not accepted by the actor
+	// (closed, or a full mailbox refused it)
+	// delayed sends can be cancelled through it
+	class Token {
+	public:
+		Token() noexcept = default;
+		explicit Token(bool accepted) noexcept: _accepted(accepted) {}
+		Token(std::weak_ptr<Actor> actor, uint32_t slot, uint32_t generation) noexcept: _actor(std::move(actor)), _slot(slot), _generation(generation), _accepted(true) {}
+		explicit operator bool() const noexcept {
+			return _accepted;
+		}
+		// thread-safe
+		// withdraws the event unless already delivered, returns if withdrawn
+		bool cancel() {
+			const SharedPtr actor = _actor.lock();
+			const bool cancelled = actor && actor->cancel(_slot, _generation);
+			_actor.reset();
+			_generation = 0;
+			return cancelled;
+		}
+	private:
+		std::weak_ptr<Actor> _actor;
+		uint32_t _slot = 0;
+		uint32_t _generation = 0;
+		bool _accepted = false;
+	};
+	
 	virtual ~Actor() = default;
-	virtual void send(EventPtr event, uint32_t delay = 0) = 0;
+	// delay in microseconds, met at the resolution of the clock of the receiver
+	virtual Token send(EventPtr event, uint64_t delay = 0) = 0;
+	// same as calling send() for each pair in [begin, end)
+	virtual void send_batch(const EventDelay* begin, const EventDelay* end) {
+		for(; begin != end; ++begin) {
+			send(begin->first, begin->second);
+		}
+	}
+	void send_batch(const std::vector<EventDelay>& events) {
+		send_batch(events.data(), events.data() + events.size());
+	}
+	void send_batch(std::initializer_list<EventDelay> events) {
+		send_batch(events.begin(), events.end());
+	}
+	// thread-safe
+	// ready events waiting to be processed, 0 if not tracked
+	virtual size_t depth() const noexcept {
+		return 0;
+	}
+protected:
+	// thread-safe
+	virtual bool cancel(uint32_t slot, uint32_t generation) {
+		return false;
+	}
+};
+
+// sent to the reacting actor whose send took a full mailbox past its capacity
+// with the Queue::HIGH_WATER policy, once until the receiver catches up
+class EvtHighWater: public EventType<0x8E41B7C6> {
+public:
+	EvtHighWater(std::weak_ptr<Actor> _actor, uint64_t _depth) noexcept: actor(std::move(_actor)), depth(_depth) {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u64(depth);
+	}
+	std::weak_ptr<Actor> actor;
+	uint64_t depth;
 };
 
 // not thread-safe: use only in this thread-loop
@@ -23,6 +90,10 @@ public:
 	
 	virtual ~ActorSelf() = default;
 	virtual void reset(ReactorPtr&& state = ReactorPtr()) = 0;
+	// delivers the same event every period, in microseconds,
+	// on a drift-free schedule starting one period from now
+	// cancelled by the next reset()
+	virtual void send_every(EventPtr event, uint64_t period) = 0;
 	virtual SharedPtr spawn() = 0;
 	virtual uint64_t reactive_time() const noexcept = 0;
 };
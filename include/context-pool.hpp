@@ -0,0 +1,186 @@
+#ifndef CONTEXT_POOL_HPP
+#define CONTEXT_POOL_HPP
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "loop-uv.hpp"
+#include "actor-uv.hpp"
+
+// contexts placing new actors on the least loaded loop
+// an overloaded loop migrates its runnable actors, mailbox and delayed events
+// included, to the least loaded one; actors owning uv handles never move
+// colocate() moves actors exchanging the most messages to a common context
+class ContextPool {
+public:
+	struct Colocation {
+		size_t moved = 0; // actors asked to move
+		uint64_t saved = 0; // profiled sends between pairs now sharing a context
+	};
+
+	explicit ContextPool(unsigned size): _group(LoopUV::Group::make(size > 0 ? size : 1, false)) {
+	}
+	size_t size() const noexcept {
+		return _group->size();
+	}
+	// thread-safe
+	// percent of the last window the context spent reacting
+	unsigned load(size_t index) const noexcept {
+		return _group->load(index);
+	}
+	// not thread-safe: set before exec()
+	// migrates one actor per window of window ms while a context reacts more
+	// than threshold percent of the time, 0 disables migration
+	void set_migration(unsigned threshold, uint32_t window = 100) noexcept {
+		_group->set_migration(threshold, window);
+	}
+	// not thread-safe: set before spawn()
+	// profiles the receivers of every actor spawned afterwards
+	void set_affinity_profile(bool enabled) noexcept {
+		_profile = enabled;
+	}
+	// not thread-safe
+	ActorUV::SharedPtr spawn() {
+		const size_t index = _group->least_loaded(_next++);
+		ActorUV::SharedPtr actor = std::make_shared<ActorUV>(LoopUV::Group::loop(_group, index));
+		actor->set_affinity_profile(_profile);
+		if(_actors.size() == _actors.capacity()) {
+			_actors.erase(std::remove_if(_actors.begin(), _actors.end(), [](const std::weak_ptr<ActorUV>& weak) {
+				return weak.expired();
+			}), _actors.end());
+		}
+		_actors.emplace_back(actor);
+		return actor;
+	}
+	// thread-safe, except against spawn()
+	// profiled sends across contexts of the actors of the pool so far
+	uint64_t cross_sends() const noexcept {
+		uint64_t total = 0;
+		for(const auto& weak : _actors) {
+			ActorUV::SharedPtr actor = weak.lock();
+			if(actor) {
+				total += actor->cross_sends();
+			}
+		}
+		return total;
+	}
+	// thread-safe, except against spawn()
+	// pairs exchanging at least min_count profiled messages, heaviest first,
+	// are moved to a common context, pinned actors stay and draw their peer
+	// a context receives at most twice its share of the actors
+	Colocation colocate(uint64_t min_count = 1) {
+		Colocation result;
+		std::unordered_map<const ActorUV*, Node> nodes;
+		for(const auto& weak : _actors) {
+			ActorUV::SharedPtr actor = weak.lock();
+			if(actor) {
+				Node& node = nodes[actor.get()];
+				node.actor = std::move(actor);
+				node.home = node.actor->home();
+			}
+		}
+		const size_t capacity = (nodes.size() + size() - 1) / size() * 2;
+		std::unordered_map<LoopUV*, size_t> count;
+		std::unordered_map<Pair, uint64_t, PairHash> weights;
+		ActorUV::Affinity peers;
+		for(auto& pair : nodes) {
+			++count[pair.second.home];
+			peers.clear();
+			pair.second.actor->affinity(peers);
+			for(auto& peer : peers) {
+				if(peer.first != pair.first && nodes.count(peer.first) > 0) {
+					weights[std::minmax(pair.first, peer.first)] += peer.second;
+				}
+			}
+		}
+		std::vector<Edge> edges;
+		for(auto& pair : weights) {
+			if(pair.second >= min_count) {
+				edges.emplace_back(pair.second, pair.first);
+			}
+		}
+		std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+			return a.first > b.first;
+		});
+		for(auto& edge : edges) {
+			Node& a = nodes[edge.second.first];
+			Node& b = nodes[edge.second.second];
+			if(a.home == b.home) {
+				a.fixed = true;
+				b.fixed = true;
+				continue;
+			}
+			Node* mover = nullptr;
+			Node* anchor = nullptr;
+			if(can_move(b) && count[a.home] < capacity) {
+				mover = &b;
+				anchor = &a;
+			} else if(can_move(a) && count[b.home] < capacity) {
+				mover = &a;
+				anchor = &b;
+			} else {
+				continue;
+			}
+			--count[mover->home];
+			++count[anchor->home];
+			mover->home = anchor->home;
+			mover->moved = true;
+			a.fixed = true;
+			b.fixed = true;
+			result.saved += edge.first;
+		}
+		for(auto& pair : nodes) {
+			Node& node = pair.second;
+			if(node.moved && node.home != node.actor->home()) {
+				LoopUV::migrate(node.actor, node.home);
+				++result.moved;
+			}
+		}
+		return result;
+	}
+	void exec() {
+		_threads.resize(_group->size());
+		for(size_t i = 0; i < _threads.size(); ++i) {
+			_loops.push_back(LoopUV::Group::loop(_group, i));
+		}
+		for(size_t i = 0; i < _threads.size(); ++i) {
+			UV_INVOKE(uv_thread_create(&_threads[i], thread_callback, &_loops[i]));
+		}
+	}
+	void wait() {
+		for(uv_thread_t& thread : _threads) {
+			UV_INVOKE(uv_thread_join(&thread));
+		}
+		_threads.clear();
+		_loops.clear();
+	}
+private:
+	using Pair = std::pair<const ActorUV*, const ActorUV*>;
+	using Edge = std::pair<uint64_t, Pair>;
+	struct Node {
+		ActorUV::SharedPtr actor;
+		LoopUV* home = nullptr;
+		bool fixed = false; // placed next to a heavier peer already
+		bool moved = false;
+	};
+	struct PairHash {
+		size_t operator()(const Pair& pair) const noexcept {
+			return std::hash<const ActorUV*>()(pair.first) * 31 + std::hash<const ActorUV*>()(pair.second);
+		}
+	};
+	static bool can_move(const Node& node) noexcept {
+		return !node.fixed && !node.actor->pinned();
+	}
+	static void thread_callback(void* arg) {
+		LoopUV::SharedPtr loop(*reinterpret_cast<const LoopUV::SharedPtr*>(arg));
+		loop->run();
+	}
+	LoopUV::Group::SharedPtr _group;
+	std::vector<LoopUV::SharedPtr> _loops;
+	std::vector<uv_thread_t> _threads;
+	std::vector<std::weak_ptr<ActorUV>> _actors;
+	size_t _next = 0;
+	bool _profile = false;
+};
+
+#endif
\ No newline at end of file
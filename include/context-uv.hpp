@@ -1,36 +1,71 @@
 #ifndef CONTEXT_UV_HPP
 #define CONTEXT_UV_HPP
 
+#include <memory>
+#include <vector>
+#include "loop-uv.hpp"
 #include "actor-uv.hpp"
+#include "cpu-topology.hpp"
 
 class ContextUV {
 public:
-	ContextUV(): _loop(std::make_shared<uv_loop_t>()) {
-		UV_INVOKE(uv_loop_init(_loop.get()));
+	using UniquePtr = std::unique_ptr<ContextUV>;
+	explicit ContextUV(LoopUV::Clock clock = LoopUV::MILLISECONDS): _loop(std::make_shared<LoopUV>(nullptr, clock)) {
 	}
 	~ContextUV() {
 		// TODO: assert thread terminanted
 	}
+	// one context per physical core, each pinned to its core and node
+	static std::vector<UniquePtr> per_core() {
+		std::vector<UniquePtr> result;
+		for(const CpuTopology::Core& core : CpuTopology::cores()) {
+			result.emplace_back(new ContextUV());
+			result.back()->set_cpu(core.cpu);
+			result.back()->set_numa_node(core.node);
+		}
+		return result;
+	}
 	ActorUV::SharedPtr spawn() {
 		return std::make_shared<ActorUV>(_loop);
 	}
 	std::shared_ptr<uv_loop_t> loop() {
-		return _loop;
+		return std::shared_ptr<uv_loop_t>(_loop, _loop->raw());
+	}
+	// not thread-safe: set before exec()
+	// runs the loop thread on this cpu only, -1 (default) for any
+	void set_cpu(int cpu) noexcept {
+		_cpu = cpu;
+	}
+	// not thread-safe: set before exec()
+	// keeps the loop thread, and the memory it allocates, on this numa node
+	// -1 (default) for any
+	void set_numa_node(int node) noexcept {
+		_node = node;
+	}
+	// not thread-safe: set before exec()
+	// the loop spins on its mailboxes for window microseconds after the last
+	// task before sleeping, and senders skip waking it meanwhile
+	// trades a core for lower hop latency, 0 (default) disables it
+	void set_busy_poll(uint32_t window) noexcept {
+		_loop->set_busy_poll(uint64_t(window) * 1000);
 	}
 	void exec() {
-		UV_INVOKE(uv_thread_create(&_thread, thread_callback, &_loop));
+		UV_INVOKE(uv_thread_create(&_thread, thread_callback, this));
 	}
 	void wait() {
 		UV_INVOKE(uv_thread_join(&_thread));
 	}
 private:
 	static void thread_callback(void* arg) {
-		std::shared_ptr<uv_loop_t> loop(*reinterpret_cast<const std::shared_ptr<uv_loop_t>*>(arg));
-		UV_INVOKE(uv_run(loop.get(), UV_RUN_DEFAULT));
-		UV_INVOKE(uv_loop_close(loop.get()));
+		ContextUV* context = reinterpret_cast<ContextUV*>(arg);
+		LoopUV::SharedPtr loop(context->_loop);
+		CpuTopology::bind(context->_cpu, context->_node);
+		loop->run();
 	}
 	uv_thread_t _thread;
-	std::shared_ptr<uv_loop_t> _loop;
+	LoopUV::SharedPtr _loop;
+	int _cpu = -1;
+	int _node = -1;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#ifndef CPU_TOPOLOGY_HPP
+#define CPU_TOPOLOGY_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <set>
+#include <utility>
+#include <vector>
+#include "uv.hpp"
+#include "pool.hpp"
+#ifdef __linux__
+#include <sched.h>
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// cpus and numa nodes of the machine, read from sysfs on linux
+// elsewhere every available cpu is a core of an unknown node (-1)
+class CpuTopology {
+public:
+	struct Core {
+		int cpu; // first logical cpu of the physical core
+		int node;
+	};
+	// one entry per physical core, ordered by node then cpu
+	static std::vector<Core> cores() {
+		std::vector<Core> result;
+		std::set<std::pair<int, int>> seen;
+		for(int cpu : read_list("/sys/devices/system/cpu/online")) {
+			const int package = read_int("/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+			const int core = read_int("/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+			if(seen.insert(std::make_pair(package, core < 0 ? cpu : core)).second) {
+				result.push_back(Core{cpu, node_of(cpu)});
+			}
+		}
+		if(result.empty()) {
+			for(unsigned cpu = 0; cpu < uv_available_parallelism(); ++cpu) {
+				result.push_back(Core{static_cast<int>(cpu), -1});
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), [](const Core& a, const Core& b) {
+			return a.node < b.node;
+		});
+		return result;
+	}
+	// logical cpus of a numa node
+	static std::vector<int> node_cpus(int node) {
+		char path[64];
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+		return read_list(path);
+	}
+	static int node_of(int cpu) {
+		for(int node : read_list("/sys/devices/system/node/online")) {
+			for(int other : node_cpus(node)) {
+				if(other == cpu) {
+					return node;
+				}
+			}
+		}
+		return -1;
+	}
+	// binds the calling thread to cpu, or to the cpus of node when cpu is -1
+	// memory the thread allocates afterwards, like its event pool, prefers node
+	// -1 leaves either unbound
+	static void bind(int cpu, int node) {
+		std::vector<int> cpus;
+		if(cpu >= 0) {
+			cpus.push_back(cpu);
+		} else if(node >= 0) {
+			cpus = node_cpus(node);
+		}
+#ifdef __linux__
+		if(!cpus.empty()) {
+			cpu_set_t mask;
+			CPU_ZERO(&mask);
+			for(int index : cpus) {
+				if(index < CPU_SETSIZE) {
+					CPU_SET(index, &mask);
+				}
+			}
+			if(sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+				throw ExceptionUV(uv_translate_sys_error(errno));
+			}
+		}
+		if(node >= 0) {
+			const unsigned long bits = 8 * sizeof(unsigned long);
+			std::vector<unsigned long> nodes(node / bits + 1, 0);
+			nodes[node / bits] |= 1ul << (node % bits);
+			if(syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodes.data(), nodes.size() * bits + 1) != 0) {
+				throw ExceptionUV(uv_translate_sys_error(errno));
+			}
+		}
+#else
+		if(!cpus.empty()) {
+			const int size = uv_cpumask_size();
+			UV_INVOKE(size);
+			std::vector<char> mask(size, 0);
+			for(int index : cpus) {
+				if(index < size) {
+					mask[index] = 1;
+				}
+			}
+			uv_thread_t self = uv_thread_self();
+			UV_INVOKE(uv_thread_setaffinity(&self, mask.data(), nullptr, mask.size()));
+		}
+#endif
+		Pool::local(); // first touch from the bound thread
+	}
+private:
+	static int read_int(const char* format, int cpu) {
+		char path[128];
+		snprintf(path, sizeof(path), format, cpu);
+		FILE* file = fopen(path, "r");
+		if(file == nullptr) {
+			return -1;
+		}
+		int value = -1;
+		if(fscanf(file, "%d", &value) != 1) {
+			value = -1;
+		}
+		fclose(file);
+		return value;
+	}
+	// parses a cpu list like "0-3,8,10-11"
+	static std::vector<int> read_list(const char* path) {
+		std::vector<int> result;
+		FILE* file = fopen(path, "r");
+		if(file == nullptr) {
+			return result;
+		}
+		int first = 0;
+		while(fscanf(file, "%d", &first) == 1) {
+			int last = first;
+			int c = fgetc(file);
+			if(c == '-') {
+				if(fscanf(file, "%d", &last) != 1) {
+					break;
+				}
+				c = fgetc(file);
+			}
+			for(int cpu = first; cpu <= last; ++cpu) {
+				result.push_back(cpu);
+			}
+			if(c != ',') {
+				break;
+			}
+		}
+		fclose(file);
+		return result;
+	}
+};
+
+#endif
\ No newline at end of file
@@ -1,30 +1,201 @@
 #ifndef EVENT_HPP
 #define EVENT_HPP
 
+#include <atomic>
 #include <cstdint>
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include "pool.hpp"
 #include "writer.hpp"
 
 class Event {
 public:
-	using SharedPtr = std::shared_ptr<const Event>;
+	class SharedPtr;
 	
+	// bytes available to inline events inside a SharedPtr
+	enum : size_t { INLINE_SIZE = 24 };
+	
+	// inline events are stored by value in the returned handle
+	// others are allocated from the pool of the calling thread
+	// define EVENT_NO_POOL to fall back to the global heap
 	template<typename T, typename... Ts>
-	static SharedPtr make(Ts&&... ts) {
-		return std::make_shared<T>(std::forward<Ts>(ts)...);
-	}
+	static SharedPtr make(Ts&&... ts);
 	
 	explicit Event(uint32_t _type) noexcept: type(_type) {}
+	Event(const Event& other) noexcept: type(other.type) {}
+	Event& operator=(const Event&) = delete;
 	virtual ~Event() = default;
 	
 	virtual void dump(Writer& writer) const = 0;
+	// may be refused by a full mailbox with the Queue::DROP_DROPPABLE policy
+	virtual bool droppable() const noexcept {
+		return false;
+	}
 	
 	template<typename T>
 	const T& as() const noexcept {
 		return *static_cast<const T*>(this);
 	}
+	// thread-safe
+	// switches the reference count to atomic operations
+	// Actor implementations call it before an event can reach another thread
+	void share() const noexcept {
+		if(_local.load(std::memory_order_relaxed)) {
+			_local.store(false, std::memory_order_relaxed);
+		}
+	}
+	bool is_shared() const noexcept {
+		return !_local.load(std::memory_order_relaxed);
+	}
 	
 	const uint32_t type;
+#ifndef EVENT_NO_POOL
+	static void* operator new(size_t size) {
+		return Pool::allocate(size);
+	}
+	static void operator delete(void* ptr) noexcept {
+		Pool::deallocate(ptr);
+	}
+#endif
+protected:
+	// copies an inline event into the storage of another handle
+	virtual const Event* clone_into(void* storage) const noexcept {
+		return nullptr;
+	}
+private:
+	template<typename T, typename... Ts>
+	static SharedPtr construct(std::true_type, Ts&&... ts);
+	template<typename T, typename... Ts>
+	static SharedPtr construct(std::false_type, Ts&&... ts);
+	
+	// while local only the creating thread holds references
+	// so the count is updated without read-modify-write instructions
+	void retain() const noexcept {
+		if(_local.load(std::memory_order_relaxed)) {
+			_refs.store(_refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		} else {
+			_refs.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	void release() const noexcept {
+		if(_local.load(std::memory_order_relaxed)) {
+			const uint32_t refs = _refs.load(std::memory_order_relaxed) - 1;
+			_refs.store(refs, std::memory_order_relaxed);
+			if(refs == 0) {
+				delete this;
+			}
+		} else if(_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete this;
+		}
+	}
+	
+	mutable std::atomic<uint32_t> _refs{0};
+	mutable std::atomic<bool> _local{true};
+};
+
+// reference to an immutable event
+// heap events are shared through an intrusive count, inline events are copied
+class Event::SharedPtr {
+	friend class Event;
+	template<typename T>
+	struct InPlace {};
+public:
+	SharedPtr() noexcept = default;
+	SharedPtr(std::nullptr_t) noexcept {}
+	explicit SharedPtr(const Event* event) noexcept: _event(event) {
+		if(_event != nullptr) {
+			_event->retain();
+		}
+	}
+	SharedPtr(const SharedPtr& other) noexcept {
+		copy(other);
+	}
+	SharedPtr(SharedPtr&& other) noexcept {
+		steal(other);
+	}
+	~SharedPtr() noexcept {
+		reset();
+	}
+	SharedPtr& operator=(const SharedPtr& other) noexcept {
+		SharedPtr tmp(other);
+		reset();
+		steal(tmp);
+		return *this;
+	}
+	SharedPtr& operator=(SharedPtr&& other) noexcept {
+		SharedPtr tmp(std::move(other));
+		reset();
+		steal(tmp);
+		return *this;
+	}
+	void swap(SharedPtr& other) noexcept {
+		SharedPtr tmp(std::move(other));
+		other.steal(*this);
+		steal(tmp);
+	}
+	void reset() noexcept {
+		if(_event == nullptr) {
+			return;
+		}
+		if(is_inline()) {
+			_event->~Event();
+		} else {
+			_event->release();
+		}
+		_event = nullptr;
+	}
+	const Event* get() const noexcept {
+		return _event;
+	}
+	const Event* operator->() const noexcept {
+		return _event;
+	}
+	const Event& operator*() const noexcept {
+		return *_event;
+	}
+	explicit operator bool() const noexcept {
+		return _event != nullptr;
+	}
+	bool is_inline() const noexcept {
+		const char* ptr = reinterpret_cast<const char*>(_event);
+		const char* storage = reinterpret_cast<const char*>(&_storage);
+		return ptr >= storage && ptr < storage + sizeof(_storage);
+	}
+	bool operator==(const SharedPtr& other) const noexcept {
+		return _event == other._event;
+	}
+	bool operator!=(const SharedPtr& other) const noexcept {
+		return _event != other._event;
+	}
+private:
+	template<typename T, typename... Ts>
+	SharedPtr(InPlace<T>, Ts&&... ts) {
+		_event = ::new(&_storage) T(std::forward<Ts>(ts)...);
+	}
+	// expects an empty handle
+	void copy(const SharedPtr& other) noexcept {
+		if(other.is_inline()) {
+			_event = other._event->clone_into(&_storage);
+		} else if(other._event != nullptr) {
+			_event = other._event;
+			_event->retain();
+		}
+	}
+	// expects an empty handle
+	void steal(SharedPtr& other) noexcept {
+		if(other.is_inline()) {
+			copy(other);
+			other.reset();
+		} else {
+			_event = other._event;
+			other._event = nullptr;
+		}
+	}
+
+	const Event* _event = nullptr;
+	typename std::aligned_storage<INLINE_SIZE, alignof(void*)>::type _storage;
 };
 
 template<uint32_t T>
@@ -34,4 +205,33 @@ public:
 	EventType() noexcept: Event(TYPE) {}
 };
 
+// small trivially copyable event stored by value in its handles
+// no allocation and no reference count, every copy of the handle copies it
+template<uint32_t T, typename Derived>
+class InlineEventType: public EventType<T> {
+protected:
+	const Event* clone_into(void* storage) const noexcept override {
+		return ::new(storage) Derived(static_cast<const Derived&>(*this));
+	}
+};
+
+template<typename T, typename... Ts>
+Event::SharedPtr Event::make(Ts&&... ts) {
+	static_assert(std::is_base_of<Event, T>::value, "events must derive from Event");
+	return construct<T>(std::is_base_of<InlineEventType<T::TYPE, T>, T>(), std::forward<Ts>(ts)...);
+}
+
+template<typename T, typename... Ts>
+Event::SharedPtr Event::construct(std::true_type, Ts&&... ts) {
+	static_assert(sizeof(T) <= INLINE_SIZE, "inline event too large");
+	static_assert(alignof(T) <= alignof(void*), "inline event over-aligned");
+	static_assert(std::is_nothrow_copy_constructible<T>::value, "inline event copy may throw");
+	return SharedPtr(SharedPtr::InPlace<T>(), std::forward<Ts>(ts)...);
+}
+
+template<typename T, typename... Ts>
+Event::SharedPtr Event::construct(std::false_type, Ts&&... ts) {
+	return SharedPtr(new T(std::forward<Ts>(ts)...));
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,580 @@
+#ifndef LOOP_UV_HPP
+#define LOOP_UV_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "uv.hpp"
+#include "pool.hpp"
+#include "timer-wheel.hpp"
+
+// uv loop shared by a context and its actors
+// one async handle wakes the loop for every runnable task
+// one timer, driven by a timer wheel, wakes it for every task deadline
+// loops of a group hand runnable tasks to idle siblings (work stealing)
+// or to the least loaded sibling once over a load threshold (migration)
+class LoopUV {
+	enum {
+		MAX_PASSES = 64,
+		LOAD_SCALE = 100,
+		POLL_SPINS = 64,
+		SPIN_TIME = 1000, // microseconds spun before a microsecond deadline
+	};
+public:
+	using SharedPtr = std::shared_ptr<LoopUV>;
+	// resolution of the timers, times are in microseconds either way
+	// the millisecond clock reads uv_now() and rounds deadlines up to the next
+	// millisecond, the microsecond clock reads uv_hrtime() and spins the last
+	// SPIN_TIME before each deadline, as uv timers only have millisecond resolution
+	enum Clock {
+		MILLISECONDS,
+		MICROSECONDS,
+	};
+
+	// something the loop runs once per schedule() or armed deadline
+	// a task only runs, and only touches its timer, in its home loop
+	class Task: private TimerWheel::Entry {
+		friend class LoopUV;
+	public:
+		explicit Task(LoopUV* home) noexcept: _home(home) {}
+		virtual ~Task() = default;
+		// thread-safe
+		LoopUV* home() const noexcept {
+			return _home.load(std::memory_order_acquire);
+		}
+		// not thread-safe: use only in the home thread-loop
+		// keeps the task in its home loop, for tasks owning uv handles
+		void pin() noexcept {
+			_pinned.store(true, std::memory_order_relaxed);
+		}
+		// thread-safe
+		bool pinned() const noexcept {
+			return _pinned.load(std::memory_order_relaxed);
+		}
+	protected:
+		virtual void run() = 0;
+		virtual std::shared_ptr<Task> shared_task() = 0;
+	private:
+		std::atomic<bool> _scheduled{false};
+		std::atomic<LoopUV*> _home;
+		std::atomic<LoopUV*> _destination{nullptr};
+		std::shared_ptr<Task> _keep; // owned while queued
+		Task* _next = nullptr;
+		std::atomic<bool> _pinned{false};
+	};
+
+	// loops sharing their work, and owned by it
+	// they keep running while any task of the group is retained
+	class Group {
+		friend class LoopUV;
+	public:
+		using SharedPtr = std::shared_ptr<Group>;
+		static SharedPtr make(unsigned size, bool stealing = true) {
+			SharedPtr group(new Group());
+			group->_stealing = stealing;
+			for(unsigned i = 0; i < size; ++i) {
+				group->_loops.emplace_back(new LoopUV(group.get()));
+			}
+			return group;
+		}
+		Group(const Group&) = delete;
+		Group& operator=(const Group&) = delete;
+		size_t size() const noexcept {
+			return _loops.size();
+		}
+		// shares the ownership of the group
+		static LoopUV::SharedPtr loop(const SharedPtr& group, size_t index) {
+			return LoopUV::SharedPtr(group, group->_loops[index].get());
+		}
+		// not thread-safe: set before running the loops
+		// a loop reacting more than threshold percent of a window of window ms
+		// moves one runnable task to its least loaded sibling, 0 disables it
+		// load() is sampled over the same window, 100 ms by default
+		void set_migration(unsigned threshold, uint32_t window) noexcept {
+			_threshold = threshold;
+			_window = uint64_t(window) * 1000000;
+		}
+		// thread-safe
+		// percent of the last window a loop spent reacting
+		unsigned load(size_t index) const noexcept {
+			return _loops[index]->_load.load(std::memory_order_relaxed);
+		}
+		// thread-safe
+		// index of the least loaded loop, the first one after hint on ties
+		size_t least_loaded(size_t hint = 0) const noexcept {
+			size_t best = hint % _loops.size();
+			for(size_t i = 1; i < _loops.size(); ++i) {
+				const size_t index = (hint + i) % _loops.size();
+				if(load(index) < load(best)) {
+					best = index;
+				}
+			}
+			return best;
+		}
+	private:
+		Group() = default;
+		// a hungry sibling, claimed for one handoff, or nullptr
+		LoopUV* claim_hungry(LoopUV* self) noexcept {
+			for(auto& loop : _loops) {
+				if(loop.get() != self && loop->_hungry.load(std::memory_order_relaxed)) {
+					bool expected = true;
+					if(loop->_hungry.compare_exchange_strong(expected, false, std::memory_order_acq_rel)) {
+						_hungry.fetch_sub(1, std::memory_order_relaxed);
+						return loop.get();
+					}
+				}
+			}
+			return nullptr;
+		}
+		void wake_all() {
+			for(auto& loop : _loops) {
+				UV_INVOKE(uv_async_send(&loop->_async));
+			}
+		}
+
+		std::vector<std::unique_ptr<LoopUV>> _loops;
+		std::atomic<unsigned> _running{0};
+		std::atomic<unsigned> _hungry{0};
+		uint64_t _window = 100000000;
+		unsigned _threshold = 0;
+		bool _stealing = true;
+	};
+
+	explicit LoopUV(Group* group = nullptr, Clock clock = MILLISECONDS): _group(group), _clock(clock) {
+		UV_INVOKE(uv_loop_init(&_loop));
+		UV_INVOKE(uv_async_init(&_loop, &_async, async_callback));
+		UV_INVOKE(uv_timer_init(&_loop, &_timer));
+		_async.data = this;
+		_timer.data = this;
+		uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+		uv_unref(reinterpret_cast<uv_handle_t*>(&_timer));
+		_wheel.advance(ticks(), _expired);
+	}
+	LoopUV(const LoopUV&) = delete;
+	LoopUV& operator=(const LoopUV&) = delete;
+	~LoopUV() noexcept {
+		release(_tasks.exchange(nullptr, std::memory_order_acquire));
+	}
+	uv_loop_t* raw() noexcept {
+		return &_loop;
+	}
+	Clock clock() const noexcept {
+		return _clock;
+	}
+	// tasks of a grouped loop may migrate to the thread of another loop
+	bool grouped() const noexcept {
+		return _group != nullptr;
+	}
+	// not thread-safe: use only in this thread-loop
+	// microseconds, at the resolution of the clock
+	uint64_t now() noexcept {
+		return _clock == MICROSECONDS ? uv_hrtime() / 1000 : uv_now(&_loop) * 1000;
+	}
+	// thread-safe
+	// queues the task unless already queued
+	// wakes the loop if it was idle and is neither draining nor spinning
+	void schedule(std::shared_ptr<Task> task) {
+		if(task->_scheduled.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+		if(push(std::move(task))) {
+			wake();
+		}
+	}
+	// not thread-safe: set before run()
+	// after running tasks, the loop polls its run queue and libuv without
+	// blocking for window nanoseconds before it sleeps, 0 (default) disables it
+	// each task found restarts the window, so the loop spins while traffic lasts
+	void set_busy_poll(uint64_t window) noexcept {
+		_spin_window = window;
+	}
+	// thread-safe
+	// moves the task to target, a loop of the same group, on its next run
+	// ignored for pinned tasks
+	static void migrate(std::shared_ptr<Task> task, LoopUV* target) {
+		task->_destination.store(target, std::memory_order_release);
+		task->home()->schedule(std::move(task));
+	}
+	// not thread-safe: use only in this thread-loop
+	// queues the task unless already queued, to run after the loop went
+	// through its timers and I/O once more
+	void yield(std::shared_ptr<Task> task) {
+		if(task->_scheduled.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+		_yielded.push_back(std::move(task));
+	}
+	// not thread-safe: use only in this thread-loop
+	// the loop keeps running while at least one task is retained
+	void retain() noexcept {
+		if(_group != nullptr) {
+			_group->_running.fetch_add(1, std::memory_order_acq_rel);
+			sync_ref();
+		} else if(_retained++ == 0) {
+			uv_ref(reinterpret_cast<uv_handle_t*>(&_async));
+		}
+	}
+	void release() {
+		if(_group != nullptr) {
+			if(_group->_running.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				_group->wake_all();
+			}
+		} else if(--_retained == 0) {
+			uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+		}
+	}
+	// not thread-safe: use only in this thread-loop
+	// runs the task once now() reaches the deadline, in microseconds
+	void arm(Task& task, uint64_t deadline) {
+		arm_ticks(task, to_ticks(deadline));
+	}
+	// not thread-safe: use only in this thread-loop
+	// same as arm(), unless already armed for an earlier deadline
+	void arm_before(Task& task, uint64_t deadline) {
+		const uint64_t tick = to_ticks(deadline);
+		if(!task.armed() || tick < task.deadline()) {
+			arm_ticks(task, tick);
+		}
+	}
+	void disarm(Task& task) noexcept {
+		_wheel.cancel(task);
+	}
+	// not thread-safe: use only in this thread-loop
+	// adds reaction time of a task, in nanoseconds, to the load of the loop
+	void account(uint64_t time) noexcept {
+		_busy += time;
+	}
+	// runs the loop until nothing is retained, then closes it
+	void run() {
+		if(_group != nullptr) {
+			sync_ref();
+		}
+		if(_spin_window > 0) {
+			run_busy_poll();
+		} else {
+			UV_INVOKE(uv_run(&_loop, UV_RUN_DEFAULT));
+		}
+		uv_close(reinterpret_cast<uv_handle_t*>(&_async), nullptr);
+		uv_close(reinterpret_cast<uv_handle_t*>(&_timer), nullptr);
+		UV_INVOKE(uv_run(&_loop, UV_RUN_DEFAULT));
+		UV_INVOKE(uv_loop_close(&_loop));
+	}
+private:
+	static void async_callback(uv_async_t* handle) {
+		LoopUV* loop = reinterpret_cast<LoopUV*>(handle->data);
+		loop->turn();
+	}
+	static void timer_callback(uv_timer_t* handle) {
+		LoopUV* loop = reinterpret_cast<LoopUV*>(handle->data);
+		loop->on_timer();
+		loop->turn();
+	}
+	// time of the wheel and the uv timer, in the unit of the clock
+	uint64_t ticks() noexcept {
+		return _clock == MICROSECONDS ? uv_hrtime() / 1000 : uv_now(&_loop);
+	}
+	// rounded up, so a deadline never expires early
+	uint64_t to_ticks(uint64_t time) const noexcept {
+		return _clock == MICROSECONDS ? time : time / 1000 + (time % 1000 != 0);
+	}
+	void arm_ticks(Task& task, uint64_t tick) {
+		_wheel.arm(task, tick);
+		if(tick < _timer_deadline) {
+			update_timer();
+		}
+	}
+	static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#endif
+	}
+	// runs what is runnable, then gives control back to libuv
+	void turn() {
+		drain();
+		requeue();
+		update_timer();
+		idle();
+		sample();
+		Pool::flush();
+	}
+	// spins on the run queue, polling libuv every POLL_SPINS rounds, and only
+	// blocks in libuv once a whole window went by without tasks
+	void run_busy_poll() {
+		for(;;) {
+			_spinning.store(true, std::memory_order_seq_cst);
+			uint64_t deadline = uv_hrtime() + _spin_window;
+			bool alive = true;
+			for(unsigned spin = 1; ; ++spin) {
+				if(_tasks.load(std::memory_order_acquire) != nullptr) {
+					turn();
+					deadline = uv_hrtime() + _spin_window;
+				} else {
+					cpu_relax();
+				}
+				if(spin % POLL_SPINS == 0) {
+					alive = uv_run(&_loop, UV_RUN_NOWAIT) != 0;
+					if(!alive || uv_hrtime() >= deadline) {
+						break;
+					}
+				}
+			}
+			_spinning.store(false, std::memory_order_seq_cst);
+			if(_tasks.load(std::memory_order_seq_cst) != nullptr) {
+				continue;
+			}
+			if(!alive || uv_run(&_loop, UV_RUN_ONCE) == 0) {
+				return;
+			}
+		}
+	}
+	static void release(Task* head) noexcept {
+		while(head != nullptr) {
+			Task* next = head->_next;
+			head->_scheduled.store(false, std::memory_order_release);
+			std::shared_ptr<Task> keep(std::move(head->_keep));
+			head = next;
+		}
+	}
+	// group loops follow the retained count of the whole group
+	void sync_ref() noexcept {
+		const bool running = _group->_running.load(std::memory_order_acquire) > 0;
+		if(running != _referenced) {
+			if(running) {
+				uv_ref(reinterpret_cast<uv_handle_t*>(&_async));
+			} else {
+				uv_unref(reinterpret_cast<uv_handle_t*>(&_async));
+			}
+			_referenced = running;
+		}
+	}
+	// with nothing left to run, asks the siblings for work
+	void idle() noexcept {
+		if(_group == nullptr) {
+			return;
+		}
+		sync_ref();
+		if(_group->_stealing && _referenced && _yielded.empty() && _tasks.load(std::memory_order_acquire) == nullptr) {
+			if(!_hungry.exchange(true, std::memory_order_acq_rel)) {
+				_group->_hungry.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+	// publishes the load of the window once over, and with a migration
+	// threshold, picks a sibling to shed to
+	void sample() noexcept {
+		if(_group == nullptr) {
+			return;
+		}
+		const uint64_t cur = uv_hrtime();
+		if(_window_start == 0) {
+			_window_start = cur;
+			return;
+		}
+		const uint64_t elapsed = cur - _window_start;
+		if(elapsed < _group->_window) {
+			return;
+		}
+		const unsigned load = static_cast<unsigned>(_busy * LOAD_SCALE / elapsed);
+		_load.store(load, std::memory_order_relaxed);
+		_busy = 0;
+		_window_start = cur;
+		_shed = nullptr;
+		if(_group->_threshold > 0 && load > _group->_threshold) {
+			LoopUV* target = _group->_loops[_group->least_loaded()].get();
+			if(target != this && target->_load.load(std::memory_order_relaxed) < _group->_threshold) {
+				_shed = target;
+			}
+		}
+	}
+	// moves a runnable task to a hungry sibling, or to the sibling picked
+	// by sample(), unless pinned
+	// returns if the task was given away
+	bool donate(Task* task) {
+		if(task->pinned()) {
+			return false;
+		}
+		if(_shed != nullptr) {
+			hand_over(task, _shed);
+			_shed = nullptr;
+			return true;
+		}
+		if(_group->_hungry.load(std::memory_order_relaxed) == 0) {
+			return false;
+		}
+		LoopUV* thief = _group->claim_hungry(this);
+		if(thief == nullptr) {
+			return false;
+		}
+		hand_over(task, thief);
+		return true;
+	}
+	// the task reacts in target from now on, its deadline is armed there on its next run
+	void hand_over(Task* task, LoopUV* target) {
+		_wheel.cancel(*task);
+		task->_home.store(target, std::memory_order_release);
+		target->push(std::move(task->_keep));
+		target->wake();
+	}
+	// thread-safe
+	// after a push, wakes the loop unless draining or spinning, as it then
+	// checks its run queue again before going to sleep
+	void wake() {
+		if(!_draining.load(std::memory_order_seq_cst) && !_spinning.load(std::memory_order_seq_cst)) {
+			UV_INVOKE(uv_async_send(&_async));
+		}
+	}
+	// returns if the run queue was empty
+	bool push(std::shared_ptr<Task>&& task) {
+		Task* raw = task.get();
+		raw->_keep = std::move(task);
+		Task* head = _tasks.load(std::memory_order_relaxed);
+		do {
+			raw->_next = head;
+		} while(!_tasks.compare_exchange_weak(head, raw, std::memory_order_seq_cst, std::memory_order_relaxed));
+		return head == nullptr;
+	}
+	// moves the yielded tasks to the run queue for the next loop iteration
+	void requeue() {
+		if(_yielded.empty()) {
+			return;
+		}
+		for(std::shared_ptr<Task>& task : _yielded) {
+			push(std::move(task));
+		}
+		_yielded.clear();
+		if(!_spinning.load(std::memory_order_relaxed)) {
+			UV_INVOKE(uv_async_send(&_async));
+		}
+	}
+	// queues every task whose deadline has passed
+	void on_timer() {
+		if(_clock == MICROSECONDS) {
+			const uint64_t cur = ticks();
+			if(cur < _timer_deadline && _timer_deadline - cur <= SPIN_TIME) {
+				while(ticks() < _timer_deadline) {
+					cpu_relax();
+				}
+			}
+		}
+		_timer_deadline = UINT64_MAX;
+		_expired.clear();
+		_wheel.advance(ticks(), _expired);
+		_draining.store(true, std::memory_order_seq_cst);
+		for(TimerWheel::Entry* entry : _expired) {
+			schedule(static_cast<Task*>(entry)->shared_task());
+		}
+		_expired.clear();
+	}
+	// starts the timer for the earliest deadline of the wheel
+	void update_timer() {
+		const uint64_t next = _wheel.next_deadline();
+		if(next == _timer_deadline) {
+			return;
+		}
+		if(next == UINT64_MAX) {
+			UV_INVOKE(uv_timer_stop(&_timer));
+		} else {
+			const uint64_t cur = ticks();
+			uint64_t timeout = next > cur ? next - cur : 0;
+			if(_clock == MICROSECONDS) {
+				// rounded up, a 0 ms timer short of the spin would fire in a loop
+				timeout = timeout > SPIN_TIME ? (timeout - SPIN_TIME + 999) / 1000 : 0;
+			}
+			UV_INVOKE(uv_timer_start(&_timer, timer_callback, timeout, 0));
+		}
+		_timer_deadline = next;
+	}
+	// drains the run queue, including tasks scheduled meanwhile
+	// gives control back to libuv after MAX_PASSES to keep I/O flowing
+	void drain() {
+		if(_hungry.load(std::memory_order_relaxed) && _hungry.exchange(false, std::memory_order_acq_rel)) {
+			_group->_hungry.fetch_sub(1, std::memory_order_relaxed);
+		}
+		_draining.store(true, std::memory_order_seq_cst);
+		for(unsigned pass = 0; pass < MAX_PASSES; ++pass) {
+			try {
+				run_tasks();
+			} catch(...) {
+				_draining.store(false, std::memory_order_seq_cst);
+				throw;
+			}
+			if(_tasks.load(std::memory_order_seq_cst) == nullptr) {
+				_draining.store(false, std::memory_order_seq_cst);
+				if(_tasks.load(std::memory_order_seq_cst) == nullptr) {
+					return;
+				}
+				_draining.store(true, std::memory_order_seq_cst);
+			}
+		}
+		_draining.store(false, std::memory_order_seq_cst);
+		if(!_spinning.load(std::memory_order_relaxed)) {
+			UV_INVOKE(uv_async_send(&_async));
+		}
+	}
+	// runs every task queued so far in schedule order
+	void run_tasks() {
+		Task* head = _tasks.exchange(nullptr, std::memory_order_acquire);
+		Task* prev = nullptr;
+		while(head != nullptr) {
+			Task* next = head->_next;
+			head->_next = prev;
+			prev = head;
+			head = next;
+		}
+		while(prev != nullptr) {
+			Task* next = prev->_next;
+			LoopUV* home = prev->home();
+			if(home != this) {
+				// scheduled through its previous home
+				home->push(std::move(prev->_keep));
+				home->wake();
+				prev = next;
+				continue;
+			}
+			if(prev->_destination.load(std::memory_order_relaxed) != nullptr) {
+				LoopUV* destination = prev->_destination.exchange(nullptr, std::memory_order_acq_rel);
+				if(destination != nullptr && destination != this && !prev->pinned()) {
+					hand_over(prev, destination);
+					prev = next;
+					continue;
+				}
+			}
+			if(_group != nullptr && next != nullptr && donate(prev)) {
+				prev = next;
+				continue;
+			}
+			std::shared_ptr<Task> keep(std::move(prev->_keep));
+			prev->_scheduled.store(false, std::memory_order_release);
+			try {
+				keep->run();
+			} catch(...) {
+				release(next);
+				throw;
+			}
+			prev = next;
+		}
+	}
+
+	uv_loop_t _loop;
+	uv_async_t _async;
+	uv_timer_t _timer;
+	TimerWheel _wheel;
+	std::vector<TimerWheel::Entry*> _expired;
+	std::vector<std::shared_ptr<Task>> _yielded;
+	uint64_t _timer_deadline = UINT64_MAX;
+	std::atomic<Task*> _tasks{nullptr};
+	std::atomic<bool> _draining{false};
+	std::atomic<bool> _spinning{false};
+	std::atomic<bool> _hungry{false};
+	std::atomic<unsigned> _load{0};
+	Group* const _group;
+	const Clock _clock;
+	LoopUV* _shed = nullptr;
+	uint64_t _busy = 0;
+	uint64_t _window_start = 0;
+	uint64_t _spin_window = 0;
+	unsigned _retained = 0;
+	bool _referenced = false;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+#ifndef MAILBOX_HPP
+#define MAILBOX_HPP
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include "pool.hpp"
+#include "event.hpp"
+
+// lock-free multi-producer / single-consumer list of ready events
+// producers push onto an atomic stack, the consumer takes the whole stack at once
+class Mailbox {
+public:
+	using EventPtr = Event::SharedPtr;
+	using EventPair = std::pair<EventPtr, uint64_t>;
+	using EventVector = std::vector<EventPair>;
+	using EventDelay = std::pair<EventPtr, uint64_t>;
+	enum Push {
+		CLOSED,
+		PUSHED,
+		PUSHED_FIRST, // the consumer must be notified
+	};
+
+	Mailbox() noexcept: _head(closed()) {}
+	Mailbox(const Mailbox&) = delete;
+	Mailbox& operator=(const Mailbox&) = delete;
+	~Mailbox() noexcept {
+		release(_head.load(std::memory_order_acquire));
+	}
+	// thread-safe
+	bool is_open() const noexcept {
+		return _head.load(std::memory_order_acquire) != closed();
+	}
+	// consumer only
+	void open() noexcept {
+		Node* expected = closed();
+		_head.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+	}
+	// consumer only
+	// drops every pending event, returns how many
+	size_t close() noexcept {
+		return release(_head.exchange(closed(), std::memory_order_acq_rel));
+	}
+	// thread-safe
+	Push push(EventPtr&& event, uint64_t timestamp) {
+		Node* node = new Node(std::move(event), timestamp);
+		Node* head = _head.load(std::memory_order_relaxed);
+		do {
+			if(head == closed()) {
+				delete node;
+				return CLOSED;
+			}
+			node->next = head;
+		} while(!_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+		return head == nullptr ? PUSHED_FIRST : PUSHED;
+	}
+	// thread-safe
+	// pushes the pairs of [begin, end) without delay in a single atomic exchange
+	Push push_ready(const EventDelay* begin, const EventDelay* end, uint64_t timestamp) {
+		Node* top = nullptr;
+		Node* bottom = nullptr;
+		for(; begin != end; ++begin) {
+			if(begin->second == 0) {
+				Node* node = new Node(EventPtr(begin->first), timestamp);
+				node->next = top;
+				top = node;
+				if(bottom == nullptr) {
+					bottom = node;
+				}
+			}
+		}
+		if(top == nullptr) {
+			return is_open() ? PUSHED : CLOSED;
+		}
+		Node* head = _head.load(std::memory_order_relaxed);
+		do {
+			if(head == closed()) {
+				release(top);
+				return CLOSED;
+			}
+			bottom->next = head;
+		} while(!_head.compare_exchange_weak(head, top, std::memory_order_release, std::memory_order_relaxed));
+		return head == nullptr ? PUSHED_FIRST : PUSHED;
+	}
+	// consumer only
+	// appends every pending event to out in arrival order, returns how many
+	size_t pop_all(EventVector& out) {
+		Node* head = _head.load(std::memory_order_relaxed);
+		do {
+			if(head == nullptr || head == closed()) {
+				return 0;
+			}
+		} while(!_head.compare_exchange_weak(head, nullptr, std::memory_order_acquire, std::memory_order_relaxed));
+		const size_t size = out.size();
+		Node* prev = nullptr;
+		while(head != nullptr) {
+			Node* next = head->next;
+			head->next = prev;
+			prev = head;
+			head = next;
+		}
+		while(prev != nullptr) {
+			Node* next = prev->next;
+			out.emplace_back(std::move(prev->pair));
+			delete prev;
+			prev = next;
+		}
+		return out.size() - size;
+	}
+private:
+	struct Node {
+		static void* operator new(size_t size) {
+			return Pool::allocate(size);
+		}
+		static void operator delete(void* ptr) noexcept {
+			Pool::deallocate(ptr);
+		}
+		Node() = default;
+		Node(EventPtr&& event, uint64_t timestamp): pair(std::move(event), timestamp) {}
+		Node* next = nullptr;
+		EventPair pair;
+	};
+	static Node* closed() noexcept {
+		static Node sentinel;
+		return &sentinel;
+	}
+	static size_t release(Node* head) noexcept {
+		size_t count = 0;
+		if(head == closed()) {
+			return count;
+		}
+		while(head != nullptr) {
+			Node* next = head->next;
+			delete head;
+			head = next;
+			++count;
+		}
+		return count;
+	}
+
+	std::atomic<Node*> _head;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef OUTBOX_HPP
+#define OUTBOX_HPP
+
+#include <vector>
+#include "actor.hpp"
+
+// buffers the sends of one reaction, grouped by destination
+// flush() hands each destination its events in a single send_batch()
+class Outbox {
+	using ActorPtr = Actor::SharedPtr;
+	using EventPtr = Event::SharedPtr;
+	using EventDelay = Actor::EventDelay;
+	struct Entry {
+		ActorPtr target;
+		std::vector<EventDelay> events;
+	};
+public:
+	// outbox collecting the sends of the current thread, if any
+	static Outbox*& current() noexcept {
+		static thread_local Outbox* outbox = nullptr;
+		return outbox;
+	}
+	// makes an outbox current for the lifetime of the scope
+	class Scope {
+	public:
+		explicit Scope(Outbox& outbox) noexcept: _prev(current()) {
+			current() = &outbox;
+		}
+		~Scope() noexcept {
+			current() = _prev;
+		}
+	private:
+		Outbox* const _prev;
+	};
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+	void add(ActorPtr&& target, EventPtr&& event, uint64_t delay) {
+		Entry& entry = find(std::move(target));
+		entry.events.emplace_back(std::move(event), delay);
+	}
+	// keeps the order of events per destination
+	void flush() {
+		const size_t size = _size;
+		_size = 0;
+		_last = 0;
+		for(size_t i = 0; i < size; ++i) {
+			Entry& entry = _entries[i];
+			ActorPtr target = std::move(entry.target);
+			target->send_batch(entry.events);
+			entry.events.clear();
+		}
+	}
+private:
+	Entry& find(ActorPtr&& target) {
+		if(_last < _size && _entries[_last].target == target) {
+			return _entries[_last];
+		}
+		for(_last = 0; _last < _size; ++_last) {
+			if(_entries[_last].target == target) {
+				return _entries[_last];
+			}
+		}
+		if(_size == _entries.size()) {
+			_entries.emplace_back();
+		}
+		_entries[_size].target = std::move(target);
+		return _entries[_size++];
+	}
+	
+	std::vector<Entry> _entries;
+	size_t _size = 0;
+	size_t _last = 0;
+};
+
+#endif
\ No newline at end of file
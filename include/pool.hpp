@@ -0,0 +1,150 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// size-class allocator, one pool per thread (so one per context loop)
+// blocks freed by another thread are batched and handed back to their owner
+// pools outlive their thread, blocks may still be returned to them afterwards
+class Pool {
+	enum : size_t {
+		ALIGN = 16,
+		CLASS_SIZE = 32,
+		CLASSES = 32,
+		MAX_SIZE = CLASS_SIZE * CLASSES,
+		SLAB_SIZE = 64 * 1024,
+		REMOTE_BATCH = 64,
+	};
+	struct alignas(ALIGN) Header {
+		Pool* owner; // nullptr when not pooled
+		uint32_t size_class;
+	};
+	// remote frees of the current thread, all for the same owner
+	struct Remote {
+		~Remote() {
+			flush();
+		}
+		void flush() noexcept {
+			if(head != nullptr) {
+				owner->give_back(head, tail);
+			}
+			owner = nullptr;
+			head = nullptr;
+			tail = nullptr;
+			count = 0;
+		}
+		Pool* owner = nullptr;
+		Header* head = nullptr;
+		Header* tail = nullptr;
+		size_t count = 0;
+	};
+public:
+	// pool of the calling thread
+	static Pool& local() {
+		static thread_local Pool* pool = new Pool();
+		return *pool;
+	}
+	static void* allocate(size_t size) {
+		if(size > MAX_SIZE) {
+			Header* header = static_cast<Header*>(::operator new(sizeof(Header) + size));
+			header->owner = nullptr;
+			header->size_class = CLASSES;
+			return header + 1;
+		}
+		return local().pop(size == 0 ? 0 : (size - 1) / CLASS_SIZE);
+	}
+	static void deallocate(void* ptr) noexcept {
+		if(ptr == nullptr) {
+			return;
+		}
+		Header* header = static_cast<Header*>(ptr) - 1;
+		if(header->owner == nullptr) {
+			::operator delete(header);
+		} else if(header->owner == &local()) {
+			header->owner->push(header);
+		} else {
+			Remote& remote = remote_frees();
+			if(remote.owner != header->owner) {
+				remote.flush();
+				remote.owner = header->owner;
+			}
+			next_of(header) = remote.head;
+			remote.head = header;
+			if(remote.tail == nullptr) {
+				remote.tail = header;
+			}
+			if(++remote.count >= REMOTE_BATCH) {
+				remote.flush();
+			}
+		}
+	}
+	// hands the pending remote frees of the calling thread back to their owner
+	static void flush() noexcept {
+		remote_frees().flush();
+	}
+	Pool(const Pool&) = delete;
+	Pool& operator=(const Pool&) = delete;
+private:
+	Pool() noexcept {
+		for(Header*& head : _free) {
+			head = nullptr;
+		}
+	}
+	static Remote& remote_frees() noexcept {
+		static thread_local Remote remote;
+		return remote;
+	}
+	static Header*& next_of(Header* header) noexcept {
+		return *reinterpret_cast<Header**>(header + 1);
+	}
+	// thread-safe
+	void give_back(Header* head, Header* tail) noexcept {
+		Header* top = _remote.load(std::memory_order_relaxed);
+		do {
+			next_of(tail) = top;
+		} while(!_remote.compare_exchange_weak(top, head, std::memory_order_release, std::memory_order_relaxed));
+	}
+	void push(Header* header) noexcept {
+		next_of(header) = _free[header->size_class];
+		_free[header->size_class] = header;
+	}
+	void* pop(size_t size_class) {
+		Header* header = _free[size_class];
+		if(header == nullptr) {
+			reclaim();
+			header = _free[size_class];
+			if(header == nullptr) {
+				carve(size_class);
+				header = _free[size_class];
+			}
+		}
+		_free[size_class] = next_of(header);
+		return header + 1;
+	}
+	void reclaim() noexcept {
+		Header* header = _remote.exchange(nullptr, std::memory_order_acquire);
+		while(header != nullptr) {
+			Header* next = next_of(header);
+			push(header);
+			header = next;
+		}
+	}
+	void carve(size_t size_class) {
+		const size_t stride = sizeof(Header) + (size_class + 1) * CLASS_SIZE;
+		char* slab = static_cast<char*>(::operator new(SLAB_SIZE));
+		for(size_t offset = 0; offset + stride <= SLAB_SIZE; offset += stride) {
+			Header* header = reinterpret_cast<Header*>(slab + offset);
+			header->owner = this;
+			header->size_class = size_class;
+			push(header);
+		}
+	}
+
+	Header* _free[CLASSES];
+	std::atomic<Header*> _remote{nullptr};
+};
+
+#endif
\ No newline at end of file
@@ -1,87 +1,362 @@
 #ifndef QUEUE_HPP
 #define QUEUE_HPP
 
-#include <list>
+#include <atomic>
 #include <vector>
 #include <utility>
+#include <algorithm>
 #include <mutex>
 #include "event.hpp"
+#include "mailbox.hpp"
 
 class Queue {
 public:
 	using EventPtr = Event::SharedPtr;
 	using EventPair = std::pair<EventPtr, uint64_t>;
 	using EventVector = std::vector<EventPair>;
-	using EventList = std::list<EventPair>;
+	using EventDelay = Mailbox::EventDelay;
+	// identifies a delayed event until delivered, cancelled or the queue closed
+	struct Handle {
+		uint32_t slot = 0;
+		uint32_t generation = 0; // 0 when not queued
+	};
+	// what a bounded queue does with ready events beyond its capacity
+	enum Policy {
+		REJECT, // refused
+		// accepted, the oldest beyond capacity are dropped when the consumer
+		// takes them, so depth() may exceed the capacity in between
+		DROP_OLDEST,
+		DROP_DROPPABLE, // refused if Event::droppable(), accepted otherwise
+		HIGH_WATER, // accepted, the first one past capacity is reported
+	};
+	// bits of the result of add_ready() and add_batch()
+	enum : unsigned {
+		ACCEPTED = 1,
+		FIRST = 2, // inserted first, the consumer must be notified
+		HIGH_WATER_REACHED = 4, // crossed the capacity with the HIGH_WATER policy
+	};
+	// not thread-safe: use only in the owner thread-loop
+	// bounds the ready events pending in the queue, 0 (default) for no limit
+	// delayed events are not counted until due
+	void set_capacity(size_t capacity, Policy policy) noexcept {
+		_policy.store(policy, std::memory_order_relaxed);
+		_capacity.store(capacity, std::memory_order_relaxed);
+	}
 	// thread-safe
-	bool get_open() const {
-		std::lock_guard<std::mutex> lock(_mutex);
-		return _open;
+	size_t capacity() const noexcept {
+		return _capacity.load(std::memory_order_relaxed);
+	}
+	// thread-safe
+	// ready events pushed and not taken by the consumer yet
+	size_t depth() const noexcept {
+		return _depth.load(std::memory_order_relaxed);
+	}
+	// thread-safe
+	// events refused or dropped by the capacity policy so far
+	uint64_t dropped() const noexcept {
+		return _dropped.load(std::memory_order_relaxed);
 	}
 	// thread-safe
+	bool get_open() const {
+		return _mailbox.is_open();
+	}
+	// not thread-safe: use only in the owner thread-loop
 	void set_open(bool value) {
 		std::lock_guard<std::mutex> lock(_mutex);
 		if(_open != value) {
+			for(Waiting& waiting : _waiting) {
+				release(waiting.slot);
+			}
 			_waiting.clear();
 			_ready.clear();
+			if(value) {
+				_mailbox.open();
+			} else {
+				taken(_mailbox.close());
+			}
 			_open = value;
 		}
 	}
-	// thread-safe
-	bool add_ready(EventPtr&& event, uint64_t timestamp) {
-		std::lock_guard<std::mutex> lock(_mutex);
-		if(_open) {
-			_ready.emplace_back(std::move(event), timestamp);
+	// thread-safe, lock-free
+	// returns ACCEPTED if open and admitted by the capacity policy
+	unsigned add_ready(EventPtr&& event, uint64_t timestamp) {
+		const unsigned result = admit(event);
+		if(result == 0) {
+			return 0;
+		}
+		switch(_mailbox.push(std::move(event), timestamp)) {
+			case Mailbox::PUSHED:
+				return result;
+			case Mailbox::PUSHED_FIRST:
+				return result | FIRST;
+			default:
+				taken(1);
+				return 0;
 		}
-		return _open;
 	}
 	// thread-safe
+	// when given, handle identifies the event for cancel()
 	// returns if open and inserted first
-	bool add_waiting(EventPtr&& event, uint64_t timestamp) {
+	bool add_waiting(EventPtr&& event, uint64_t timestamp, Handle* handle = nullptr) {
 		std::lock_guard<std::mutex> lock(_mutex);
 		if(!_open) {
 			return false;
 		}
-		if(_waiting.empty() || timestamp < _waiting.front().second) {
-			_waiting.emplace_front(std::move(event), timestamp);
-			return true;
-		} else {
-			auto itr = _waiting.begin();
-			do {
-				++itr;
-			} while(itr != _waiting.end() && timestamp >= itr->second);
-			_waiting.emplace(itr, std::move(event), timestamp);
+		const uint64_t seq = _waiting_seq++;
+		uint32_t slot = NO_SLOT;
+		if(handle != nullptr) {
+			slot = acquire();
+			handle->slot = slot;
+			handle->generation = _slots[slot].generation;
+		}
+		push(Waiting{std::move(event), timestamp, seq, slot});
+		return _waiting.front().seq == seq;
+	}
+	// thread-safe
+	// removes a delayed event in O(log n), returns if it was still waiting
+	bool cancel(Handle handle) {
+		EventPtr event; // released out of the lock
+		std::lock_guard<std::mutex> lock(_mutex);
+		if(handle.generation == 0 || handle.slot >= _slots.size() || _slots[handle.slot].generation != handle.generation) {
 			return false;
 		}
+		event = erase(_slots[handle.slot].index).event;
+		release(handle.slot);
+		return true;
 	}
 	// thread-safe
+	// enqueues every (event, delay) in [begin, end) relative to timestamp
+	// ready events take one atomic exchange, delayed ones a single lock
+	// only for unbounded queues, bounded ones admit events one by one
+	// returns ACCEPTED if open, and FIRST if any of them was inserted first
+	unsigned add_batch(const EventDelay* begin, const EventDelay* end, uint64_t timestamp) {
+		size_t ready = 0;
+		bool has_delayed = false;
+		for(const EventDelay* itr = begin; itr != end; ++itr) {
+			if(itr->second > 0) {
+				has_delayed = true;
+			} else {
+				++ready;
+			}
+		}
+		_depth.fetch_add(ready, std::memory_order_relaxed);
+		unsigned result = ACCEPTED;
+		switch(_mailbox.push_ready(begin, end, timestamp)) {
+			case Mailbox::PUSHED:
+				break;
+			case Mailbox::PUSHED_FIRST:
+				result |= FIRST;
+				break;
+			default:
+				taken(ready);
+				return 0;
+		}
+		if(has_delayed) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if(_open) {
+				const uint64_t earliest = _waiting.empty() ? UINT64_MAX : _waiting.front().timestamp;
+				for(const EventDelay* itr = begin; itr != end; ++itr) {
+					if(itr->second > 0) {
+						push(Waiting{itr->first, timestamp + itr->second, _waiting_seq++, NO_SLOT});
+					}
+				}
+				if(_waiting.front().timestamp < earliest) {
+					result |= FIRST;
+				}
+			}
+		}
+		return result;
+	}
+	// not thread-safe: use only in the owner thread-loop
+	// takes the ready events, then the delayed ones found due by update()
+	// with the DROP_OLDEST policy, only the newest capacity() ready events are kept
 	void get_events(EventVector& out) {
 		out.clear();
-		/*lock context*/{
-			std::lock_guard<std::mutex> lock(_mutex);
-			std::swap(out, _ready);
+		const size_t popped = _mailbox.pop_all(out);
+		taken(popped);
+		const size_t capacity = _capacity.load(std::memory_order_relaxed);
+		if(capacity > 0 && popped > capacity && _policy.load(std::memory_order_relaxed) == DROP_OLDEST) {
+			const size_t excess = popped - capacity;
+			out.erase(out.begin(), out.begin() + excess);
+			_dropped.fetch_add(excess, std::memory_order_relaxed);
+		}
+		for(EventPair& pair : _ready) {
+			out.emplace_back(std::move(pair));
 		}
+		_ready.clear();
 	}
-	// thread-safe
+	// not thread-safe: use only in the owner thread-loop
+	// moves the due delayed events aside for get_events()
+	// returns the timestamp of the next one, 0 if none
 	uint64_t update(uint64_t timestamp) {
 		uint64_t next_timeout = 0;
 		/*lock context*/{
 			std::lock_guard<std::mutex> lock(_mutex);
-			while(!_waiting.empty() && timestamp >= _waiting.front().second) {
-				auto& pair = _waiting.front();
-				_ready.emplace_back(std::move(pair.first), pair.second);
-				_waiting.pop_front();
+			while(!_waiting.empty() && timestamp >= _waiting.front().timestamp) {
+				Waiting waiting = erase(0);
+				release(waiting.slot);
+				_ready.emplace_back(std::move(waiting.event), waiting.timestamp);
 			}
 			if(!_waiting.empty()) {
-				next_timeout = _waiting.front().second;
+				next_timeout = _waiting.front().timestamp;
 			}
 		}
 		return next_timeout;
 	}
 private:
-	mutable std::mutex _mutex;
+	enum : uint32_t {
+		NO_SLOT = UINT32_MAX,
+	};
+	// delayed event, ordered by timestamp then by arrival
+	struct Waiting {
+		EventPtr event;
+		uint64_t timestamp;
+		uint64_t seq;
+		uint32_t slot; // NO_SLOT when it cannot be cancelled
+	};
+	// position in the heap of a cancellable event
+	struct Slot {
+		uint32_t generation;
+		uint32_t index;
+	};
+	// min-heap comparator
+	struct Later {
+		bool operator()(const Waiting& a, const Waiting& b) const noexcept {
+			return a.timestamp != b.timestamp ? a.timestamp > b.timestamp : a.seq > b.seq;
+		}
+	};
+	using WaitingHeap = std::vector<Waiting>;
+	
+	// counts one more ready event unless the capacity policy refuses it
+	unsigned admit(const EventPtr& event) {
+		const size_t depth = _depth.fetch_add(1, std::memory_order_relaxed) + 1;
+		const size_t capacity = _capacity.load(std::memory_order_relaxed);
+		if(capacity == 0 || depth <= capacity) {
+			return ACCEPTED;
+		}
+		switch(_policy.load(std::memory_order_relaxed)) {
+			case REJECT:
+				break;
+			case DROP_DROPPABLE:
+				if(!event || !event->droppable()) {
+					return ACCEPTED;
+				}
+				break;
+			case DROP_OLDEST:
+				return ACCEPTED;
+			case HIGH_WATER:
+				if(_high.exchange(true, std::memory_order_relaxed)) {
+					return ACCEPTED;
+				}
+				return ACCEPTED | HIGH_WATER_REACHED;
+		}
+		_depth.fetch_sub(1, std::memory_order_relaxed);
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
+	// the high water report is armed again once down to half the capacity
+	void taken(size_t count) noexcept {
+		if(count == 0) {
+			return;
+		}
+		const size_t depth = _depth.fetch_sub(count, std::memory_order_relaxed) - count;
+		if(_high.load(std::memory_order_relaxed) && depth <= _capacity.load(std::memory_order_relaxed) / 2) {
+			_high.store(false, std::memory_order_relaxed);
+		}
+	}
+	uint32_t acquire() {
+		if(_free_slots.empty()) {
+			_slots.push_back(Slot{1, 0});
+			return static_cast<uint32_t>(_slots.size() - 1);
+		}
+		const uint32_t slot = _free_slots.back();
+		_free_slots.pop_back();
+		return slot;
+	}
+	// outdates the handles of the slot
+	void release(uint32_t slot) {
+		if(slot == NO_SLOT) {
+			return;
+		}
+		if(++_slots[slot].generation == 0) {
+			_slots[slot].generation = 1;
+		}
+		_free_slots.push_back(slot);
+	}
+	// heap operations keeping the slots pointing at their event
+	void place(size_t index) noexcept {
+		if(_waiting[index].slot != NO_SLOT) {
+			_slots[_waiting[index].slot].index = static_cast<uint32_t>(index);
+		}
+	}
+	void push(Waiting&& waiting) {
+		_waiting.push_back(std::move(waiting));
+		sift_up(_waiting.size() - 1);
+	}
+	Waiting erase(size_t index) {
+		Waiting result = std::move(_waiting[index]);
+		const size_t last = _waiting.size() - 1;
+		if(index != last) {
+			_waiting[index] = std::move(_waiting[last]);
+			_waiting.pop_back();
+			if(index > 0 && Later()(_waiting[(index - 1) / 2], _waiting[index])) {
+				sift_up(index);
+			} else {
+				sift_down(index);
+			}
+		} else {
+			_waiting.pop_back();
+		}
+		return result;
+	}
+	void sift_up(size_t index) {
+		Waiting waiting = std::move(_waiting[index]);
+		while(index > 0) {
+			const size_t parent = (index - 1) / 2;
+			if(!Later()(_waiting[parent], waiting)) {
+				break;
+			}
+			_waiting[index] = std::move(_waiting[parent]);
+			place(index);
+			index = parent;
+		}
+		_waiting[index] = std::move(waiting);
+		place(index);
+	}
+	void sift_down(size_t index) {
+		const size_t size = _waiting.size();
+		Waiting waiting = std::move(_waiting[index]);
+		for(;;) {
+			size_t child = 2 * index + 1;
+			if(child >= size) {
+				break;
+			}
+			if(child + 1 < size && Later()(_waiting[child], _waiting[child + 1])) {
+				++child;
+			}
+			if(!Later()(waiting, _waiting[child])) {
+				break;
+			}
+			_waiting[index] = std::move(_waiting[child]);
+			place(index);
+			index = child;
+		}
+		_waiting[index] = std::move(waiting);
+		place(index);
+	}
+	
+	mutable std::mutex _mutex; // guards _waiting, _slots and _open
+	Mailbox _mailbox;
 	EventVector _ready;
-	EventList _waiting;
+	WaitingHeap _waiting;
+	std::vector<Slot> _slots;
+	std::vector<uint32_t> _free_slots;
+	uint64_t _waiting_seq = 0;
+	std::atomic<size_t> _depth{0};
+	std::atomic<size_t> _capacity{0};
+	std::atomic<Policy> _policy{REJECT};
+	std::atomic<uint64_t> _dropped{0};
+	std::atomic<bool> _high{false};
 	bool _open = false;
 };
 
@@ -1,6 +1,7 @@
 #ifndef REACTOR_HPP
 #define REACTOR_HPP
 
+#include <utility>
 #include "event.hpp"
 #include "actor.hpp"
 
@@ -8,9 +9,40 @@ class Reactor {
 public:
 	using UniquePtr = std::unique_ptr<Reactor>;
 	using EventPtr = Event::SharedPtr;
+	using EventPair = std::pair<EventPtr, uint64_t>;
 	using ActorPtr = Actor::SharedPtr;
 	using SelfPtr = ActorSelf::SharedPtr;
 	
+	// run of events for one reactor
+	// empty() once the run ends or the actor switched to another state
+	class Batch {
+	public:
+		Batch(const EventPair* begin, const EventPair* end, const UniquePtr& state) noexcept: _itr(begin), _end(end), _state(state), _reactor(state.get()) {}
+		Batch(const Batch&) = delete;
+		Batch& operator=(const Batch&) = delete;
+		bool empty() const noexcept {
+			return _itr == _end || _state.get() != _reactor;
+		}
+		// events left in the run, regardless of state changes
+		size_t size() const noexcept {
+			return static_cast<size_t>(_end - _itr);
+		}
+		const EventPair& front() const noexcept {
+			return *_itr;
+		}
+		void pop_front() noexcept {
+			++_itr;
+		}
+		const EventPair* position() const noexcept {
+			return _itr;
+		}
+	private:
+		const EventPair* _itr;
+		const EventPair* const _end;
+		const UniquePtr& _state;
+		const Reactor* const _reactor;
+	};
+	
 	template<typename T, typename... Ts>
 	static UniquePtr make(Ts&&... ts) {
 		return UniquePtr(new T(std::forward<Ts>(ts)...));
@@ -19,6 +51,17 @@ public:
 	virtual ~Reactor() = default;
 	virtual void dump(Writer& writer) const = 0;
 	virtual void react(const EventPtr& event, uint64_t timestamp) = 0;
+	// consumes events from the front of the batch until it is empty
+	// a reactor replaced through ActorSelf::reset stays alive until it returns
+	virtual void react_batch(Batch& batch) {
+		while(!batch.empty()) {
+			const EventPair& pair = batch.front();
+			react(pair.first, pair.second); // can throw
+			batch.pop_front();
+		}
+	}
+	// called once after the events of a trigger were delivered
+	virtual void after_batch() {}
 };
 
 #endif
\ No newline at end of file
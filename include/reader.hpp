@@ -0,0 +1,96 @@
+#ifndef READER_HPP
+#define READER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <utility>
+
+// reads what Writer wrote, without copying blobs out of the buffer
+// reading past the end fails the reader and yields zeros / empty values
+class Reader {
+public:
+	using View = std::pair<const char*, size_t>;
+
+	Reader(const char* data, size_t size) noexcept: _data(data), _end(data + size) {}
+	explicit Reader(const std::string& buffer) noexcept: Reader(buffer.data(), buffer.size()) {}
+	bool good() const noexcept {
+		return _good;
+	}
+	size_t remaining() const noexcept {
+		return static_cast<size_t>(_end - _data);
+	}
+	bool read_bool() noexcept {
+		return read_u8() != 0;
+	}
+	uint8_t read_u8() noexcept {
+		return static_cast<uint8_t>(read_le(1));
+	}
+	uint16_t read_u16() noexcept {
+		return static_cast<uint16_t>(read_le(2));
+	}
+	uint32_t read_u32() noexcept {
+		return static_cast<uint32_t>(read_le(4));
+	}
+	uint64_t read_u64() noexcept {
+		return read_le(8);
+	}
+	int32_t read_i32() noexcept {
+		return static_cast<int32_t>(read_le(4));
+	}
+	int64_t read_i64() noexcept {
+		return static_cast<int64_t>(read_le(8));
+	}
+	double read_f64() noexcept {
+		const uint64_t bits = read_le(8);
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+	// points into the buffer, valid as long as it is
+	View read_bytes() noexcept {
+		const size_t size = read_u32();
+		if(!take(size)) {
+			return View(_data, 0);
+		}
+		return View(_data - size, size);
+	}
+	std::string read_string() {
+		const View view = read_bytes();
+		return std::string(view.first, view.second);
+	}
+	// reader over the next length-prefixed block, skipped in this one
+	Reader read_block() noexcept {
+		const View view = read_bytes();
+		Reader block(view.first, view.second);
+		block._good = _good;
+		return block;
+	}
+private:
+	bool take(size_t size) noexcept {
+		if(!_good || remaining() < size) {
+			_good = false;
+			return false;
+		}
+		_data += size;
+		return true;
+	}
+	uint64_t read_le(unsigned size) noexcept {
+		if(!take(size)) {
+			return 0;
+		}
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(_data - size);
+		uint64_t value = 0;
+		for(unsigned i = 0; i < size; ++i) {
+			value |= uint64_t(bytes[i]) << (i * 8);
+		}
+		return value;
+	}
+
+	const char* _data;
+	const char* _end;
+	bool _good = true;
+};
+
+#endif
\ No newline at end of file
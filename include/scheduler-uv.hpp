@@ -0,0 +1,51 @@
+#ifndef SCHEDULER_UV_HPP
+#define SCHEDULER_UV_HPP
+
+#include <vector>
+#include "loop-uv.hpp"
+#include "actor-uv.hpp"
+
+// worker threads sharing their actors, an alternative to one ContextUV per thread
+// runnable actors move to idle workers, an actor still reacts on one worker at a time
+// actors owning uv handles stay on the worker where they called loop()
+class SchedulerUV {
+public:
+	explicit SchedulerUV(unsigned workers): _group(LoopUV::Group::make(workers > 0 ? workers : 1)) {
+	}
+	size_t size() const noexcept {
+		return _group->size();
+	}
+	// not thread-safe
+	// initial placement is round-robin, stealing balances it afterwards
+	ActorUV::SharedPtr spawn() {
+		const size_t index = _next++ % _group->size();
+		return std::make_shared<ActorUV>(LoopUV::Group::loop(_group, index));
+	}
+	void exec() {
+		_threads.resize(_group->size());
+		for(size_t i = 0; i < _threads.size(); ++i) {
+			_loops.push_back(LoopUV::Group::loop(_group, i));
+		}
+		for(size_t i = 0; i < _threads.size(); ++i) {
+			UV_INVOKE(uv_thread_create(&_threads[i], thread_callback, &_loops[i]));
+		}
+	}
+	void wait() {
+		for(uv_thread_t& thread : _threads) {
+			UV_INVOKE(uv_thread_join(&thread));
+		}
+		_threads.clear();
+		_loops.clear();
+	}
+private:
+	static void thread_callback(void* arg) {
+		LoopUV::SharedPtr loop(*reinterpret_cast<const LoopUV::SharedPtr*>(arg));
+		loop->run();
+	}
+	LoopUV::Group::SharedPtr _group;
+	std::vector<LoopUV::SharedPtr> _loops;
+	std::vector<uv_thread_t> _threads;
+	size_t _next = 0;
+};
+
+#endif
\ No newline at end of file
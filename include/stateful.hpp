@@ -10,39 +10,59 @@ class Stateful {
 	using EventPtr = Event::SharedPtr;
 	using EventPair = std::pair<EventPtr, uint64_t>;
 	using EventVector = std::vector<EventPair>;
-	using EventItr = EventVector::const_iterator;
 	using ReactorPtr = std::unique_ptr<Reactor>;
 public:
 	bool is_running() const noexcept {
 		return !!_state;
 	}
 	bool trigger(const EventVector& events) {
-		//
-		EventItr itr = events.cbegin();
-		EventItr end = events.cend();
-		while(_state && itr != events.cend()) {
-			process(itr, end);
+		return trigger(events.data(), events.data() + events.size());
+	}
+	bool trigger(const EventPair* itr, const EventPair* end) {
+		_triggering = true;
+		try {
+			while(_state && itr != end) {
+				process(itr, end);
+				_retired.reset();
+			}
+			if(_state) {
+				_state->after_batch(); // can throw
+			}
+		} catch(...) {
+			_triggering = false;
+			_retired.reset();
+			throw;
 		}
+		_triggering = false;
+		_retired.reset();
 		return !!_state;
 	}
+	// the reactor being triggered is destroyed once its reaction returns
 	void set(ReactorPtr&& state) {
+		if(_triggering && !_retired) {
+			_retired = std::move(_state);
+		}
 		_state = std::move(state);
 	}
 private:
-	void reaction(EventItr& itr, const EventItr end) {
+	void reaction(const EventPair*& itr, const EventPair* end) {
 		Reactor* cur = _state.get();
-		while(_state.get() == cur && itr != end) {
-			_state->react(itr->first, itr->second); // can throw
-			++itr;
+		Reactor::Batch batch(itr, end, _state);
+		cur->react_batch(batch); // can throw
+		if(batch.position() == itr && _state.get() == cur) {
+			// nothing consumed, deliver one event to keep going
+			cur->react(itr->first, itr->second); // can throw
+			batch.pop_front();
 		}
+		itr = batch.position();
 	}
-	void post_factum(const EventItr ini, const EventItr end) {
-		for(EventItr itr = ini; itr <= end; ++itr) {
+	void post_factum(const EventPair* ini, const EventPair* end) {
+		for(const EventPair* itr = ini; itr < end; ++itr) {
 			// TODO
 		}
 	}
-	void process(EventItr& itr, const EventItr end) {
-		const EventItr ini = itr;
+	void process(const EventPair*& itr, const EventPair* end) {
+		const EventPair* ini = itr;
 		try {
 			reaction(itr, end); // can throw
 		} catch(...) {
@@ -51,6 +71,8 @@ private:
 		}
 	}
 	ReactorPtr _state;
+	ReactorPtr _retired;
+	bool _triggering = false;
 	//EventVector _reacting; 
 	// TODO: ? serialized reactor
 };
@@ -0,0 +1,185 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// hierarchical timer wheel of intrusive entries
+// an entry lives on the level of the highest digit where its deadline differs
+// from the current time, and cascades down as time reaches its slot
+// not thread-safe
+class TimerWheel {
+	enum : unsigned {
+		SLOT_BITS = 6,
+		SLOTS = 1u << SLOT_BITS,
+		SLOT_MASK = SLOTS - 1,
+		LEVELS = (64 + SLOT_BITS - 1) / SLOT_BITS,
+	};
+public:
+	class Entry {
+		friend class TimerWheel;
+	public:
+		Entry() noexcept = default;
+		Entry(const Entry&) = delete;
+		Entry& operator=(const Entry&) = delete;
+		bool armed() const noexcept {
+			return _next != nullptr;
+		}
+		uint64_t deadline() const noexcept {
+			return _deadline;
+		}
+	private:
+		Entry* _prev = nullptr;
+		Entry* _next = nullptr;
+		uint64_t _deadline = 0;
+		unsigned _slot = 0;
+	};
+
+	explicit TimerWheel(uint64_t now = 0) noexcept: _now(now) {
+		for(Entry& head : _slots) {
+			head._prev = &head;
+			head._next = &head;
+		}
+		for(uint64_t& bits : _occupied) {
+			bits = 0;
+		}
+	}
+	TimerWheel(const TimerWheel&) = delete;
+	TimerWheel& operator=(const TimerWheel&) = delete;
+	uint64_t now() const noexcept {
+		return _now;
+	}
+	bool empty() const noexcept {
+		return _size == 0;
+	}
+	size_t size() const noexcept {
+		return _size;
+	}
+	// (re)arms the entry, a deadline not after now() expires on the next advance()
+	void arm(Entry& entry, uint64_t deadline) noexcept {
+		if(entry.armed()) {
+			unlink(entry);
+		}
+		entry._deadline = deadline;
+		link(entry);
+	}
+	void cancel(Entry& entry) noexcept {
+		if(entry.armed()) {
+			unlink(entry);
+		}
+	}
+	// earliest time something may expire or cascade, UINT64_MAX when empty
+	uint64_t next_deadline() const noexcept {
+		uint64_t result = UINT64_MAX;
+		for(unsigned level = 0; level < LEVELS; ++level) {
+			const unsigned shift = level * SLOT_BITS;
+			const unsigned digit = (_now >> shift) & SLOT_MASK;
+			// level 0 may hold entries already due at the current digit
+			const uint64_t pending = level == 0 ? _occupied[0] >> digit << digit : _occupied[level] & ~mask_upto(digit);
+			if(pending == 0) {
+				continue;
+			}
+			const unsigned slot = __builtin_ctzll(pending);
+			const uint64_t time = boundary(level, slot);
+			if(time < result) {
+				result = time;
+			}
+		}
+		return result;
+	}
+	// moves time forward, appending every entry with deadline <= now to expired
+	// expired entries are disarmed in deadline order per slot
+	void advance(uint64_t now, std::vector<Entry*>& expired) {
+		if(now < _now) {
+			now = _now;
+		}
+		while(_size > 0) {
+			const uint64_t next = next_deadline();
+			if(next > now) {
+				break;
+			}
+			_now = next;
+			const unsigned slot = slot_of(next);
+			Entry& head = _slots[slot];
+			Entry* entry = head._next;
+			head._prev = &head;
+			head._next = &head;
+			_occupied[slot >> SLOT_BITS] &= ~(uint64_t(1) << (slot & SLOT_MASK));
+			while(entry != &head) {
+				Entry* next_entry = entry->_next;
+				entry->_prev = nullptr;
+				entry->_next = nullptr;
+				--_size;
+				if(entry->_deadline <= _now) {
+					expired.push_back(entry);
+				} else {
+					link(*entry);
+				}
+				entry = next_entry;
+			}
+		}
+		_now = now;
+	}
+private:
+	static uint64_t mask_upto(unsigned digit) noexcept {
+		return (uint64_t(2) << digit) - 1;
+	}
+	uint64_t boundary(unsigned level, unsigned slot) const noexcept {
+		const unsigned shift = level * SLOT_BITS;
+		const unsigned above = shift + SLOT_BITS;
+		const uint64_t high = above >= 64 ? 0 : (_now >> above) << above;
+		const uint64_t time = high | (uint64_t(slot) << shift);
+		return time < _now ? _now : time;
+	}
+	// slot whose boundary is the given time on the lowest level it belongs to
+	unsigned slot_of(uint64_t time) const noexcept {
+		for(unsigned level = 0; level < LEVELS; ++level) {
+			const unsigned shift = level * SLOT_BITS;
+			const unsigned slot = (time >> shift) & SLOT_MASK;
+			const unsigned index = level * SLOTS + slot;
+			if(_occupied[level] & (uint64_t(1) << slot)) {
+				if(boundary(level, slot) == time) {
+					return index;
+				}
+			}
+		}
+		return 0;
+	}
+	void link(Entry& entry) noexcept {
+		unsigned level = 0;
+		if(entry._deadline > _now) {
+			const uint64_t diff = entry._deadline ^ _now;
+			level = (63 - __builtin_clzll(diff)) / SLOT_BITS;
+		}
+		const uint64_t reference = entry._deadline > _now ? entry._deadline : _now;
+		const unsigned slot = (reference >> (level * SLOT_BITS)) & SLOT_MASK;
+		const unsigned index = level * SLOTS + slot;
+		Entry& head = _slots[index];
+		entry._slot = index;
+		entry._prev = head._prev;
+		entry._next = &head;
+		head._prev->_next = &entry;
+		head._prev = &entry;
+		_occupied[level] |= uint64_t(1) << slot;
+		++_size;
+	}
+	void unlink(Entry& entry) noexcept {
+		entry._prev->_next = entry._next;
+		entry._next->_prev = entry._prev;
+		entry._prev = nullptr;
+		entry._next = nullptr;
+		Entry& head = _slots[entry._slot];
+		if(head._next == &head) {
+			_occupied[entry._slot / SLOTS] &= ~(uint64_t(1) << (entry._slot % SLOTS));
+		}
+		--_size;
+	}
+
+	Entry _slots[LEVELS * SLOTS];
+	uint64_t _occupied[LEVELS];
+	uint64_t _now;
+	size_t _size = 0;
+};
+
+#endif
\ No newline at end of file
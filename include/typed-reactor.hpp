@@ -0,0 +1,164 @@
+#ifndef TYPED_REACTOR_HPP
+#define TYPED_REACTOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "reactor.hpp"
+
+template<typename... Ts>
+struct TypeList {};
+
+template<typename T, typename List>
+struct TypeListPrepend;
+template<typename T, typename... Ts>
+struct TypeListPrepend<T, TypeList<Ts...>> {
+	using type = TypeList<T, Ts...>;
+};
+
+// inserts T into a list of events sorted by TYPE
+template<typename T, typename List>
+struct TypeListInsert;
+template<typename T>
+struct TypeListInsert<T, TypeList<>> {
+	using type = TypeList<T>;
+};
+template<typename T, typename H, typename... Ts>
+struct TypeListInsert<T, TypeList<H, Ts...>> {
+	using type = typename std::conditional<
+		(uint32_t(T::TYPE) <= uint32_t(H::TYPE)),
+		TypeList<T, H, Ts...>,
+		typename TypeListPrepend<H, typename TypeListInsert<T, TypeList<Ts...>>::type>::type
+	>::type;
+};
+
+template<typename List>
+struct TypeListSort;
+template<>
+struct TypeListSort<TypeList<>> {
+	using type = TypeList<>;
+};
+template<typename H, typename... Ts>
+struct TypeListSort<TypeList<H, Ts...>> {
+	using type = typename TypeListInsert<H, typename TypeListSort<TypeList<Ts...>>::type>::type;
+};
+
+// true when no two events of a sorted list share a TYPE
+template<typename List>
+struct TypeListUnique: std::true_type {};
+template<typename A, typename B, typename... Ts>
+struct TypeListUnique<TypeList<A, B, Ts...>>: std::integral_constant<bool,
+	(uint32_t(A::TYPE) != uint32_t(B::TYPE)) && TypeListUnique<TypeList<B, Ts...>>::value
+> {};
+
+// dispatches each event to Derived::on(const T&, uint64_t) for T in Events
+// other types go to Derived::on_unknown(const EventPtr&, uint64_t)
+// the handlers may be private if Derived declares "friend Typed;"
+// types are sorted and checked for duplicates at compile time, the first
+// dispatch then derives a multiplicative perfect hash over them
+template<typename Derived, typename... Events>
+class TypedReactor: public Reactor {
+	using Sorted = typename TypeListSort<TypeList<Events...>>::type;
+	using Handler = void(*)(TypedReactor&, const Event&, uint64_t);
+	static constexpr size_t pow2(size_t n, size_t p = 1) {
+		return p >= n ? p : pow2(n, p * 2);
+	}
+	static constexpr unsigned log2(size_t n) {
+		return n <= 1 ? 0 : 1 + log2(n / 2);
+	}
+	enum : size_t {
+		COUNT = sizeof...(Events),
+		MIN_BITS = log2(pow2(COUNT)) + 1,
+		MAX_BITS = MIN_BITS + 3,
+		MAX_SLOTS = size_t(1) << MAX_BITS,
+		ATTEMPTS = 1024,
+	};
+	static_assert(COUNT > 0, "TypedReactor without events");
+	static_assert(TypeListUnique<Sorted>::value, "duplicate event type in TypedReactor");
+	// slot = (type * mult) >> shift, without collisions
+	// mult 0 when no multiplier was found, then the sorted table is searched
+	struct Hash {
+		Hash() noexcept {
+			const uint32_t* sorted = types(Sorted());
+			const Handler* calls = handlers(Sorted());
+			uint32_t seed = 0x9E3779B9u;
+			for(unsigned bits = MIN_BITS; bits <= MAX_BITS; ++bits) {
+				for(unsigned attempt = 0; attempt < ATTEMPTS; ++attempt) {
+					seed = seed * 1664525u + 1013904223u;
+					const uint32_t candidate = seed | 1;
+					const unsigned candidate_shift = 32 - bits;
+					bool used[MAX_SLOTS] = {};
+					size_t i = 0;
+					for(; i < COUNT; ++i) {
+						const uint32_t slot = uint32_t(sorted[i] * candidate) >> candidate_shift;
+						if(used[slot]) {
+							break;
+						}
+						used[slot] = true;
+					}
+					if(i < COUNT) {
+						continue;
+					}
+					mult = candidate;
+					shift = candidate_shift;
+					for(i = 0; i < COUNT; ++i) {
+						const uint32_t slot = uint32_t(sorted[i] * candidate) >> candidate_shift;
+						keys[slot] = sorted[i];
+						slots[slot] = calls[i];
+					}
+					return;
+				}
+			}
+		}
+		uint32_t mult = 0;
+		unsigned shift = 0;
+		uint32_t keys[MAX_SLOTS] = {};
+		Handler slots[MAX_SLOTS] = {};
+	};
+public:
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		const Handler handler = find(event->type);
+		if(handler != nullptr) {
+			handler(*this, *event, timestamp);
+		} else {
+			static_cast<Derived&>(*this).on_unknown(event, timestamp);
+		}
+	}
+protected:
+	using Typed = TypedReactor;
+	void on_unknown(const EventPtr& event, uint64_t timestamp) {}
+private:
+	static Handler find(uint32_t type) noexcept {
+		static const Hash hash;
+		if(hash.mult != 0) {
+			const uint32_t slot = uint32_t(type * hash.mult) >> hash.shift;
+			return hash.keys[slot] == type ? hash.slots[slot] : nullptr;
+		}
+		// branchless binary search
+		const uint32_t* table = types(Sorted());
+		size_t base = 0;
+		size_t size = COUNT;
+		while(size > 1) {
+			const size_t half = size / 2;
+			base = table[base + half] <= type ? base + half : base;
+			size -= half;
+		}
+		return table[base] == type ? handlers(Sorted())[base] : nullptr;
+	}
+	template<typename T>
+	static void call(TypedReactor& self, const Event& event, uint64_t timestamp) {
+		static_cast<Derived&>(self).on(event.as<T>(), timestamp);
+	}
+	template<typename... Ts>
+	static const uint32_t* types(TypeList<Ts...>) noexcept {
+		static const uint32_t table[] = { Ts::TYPE... };
+		return table;
+	}
+	template<typename... Ts>
+	static const Handler* handlers(TypeList<Ts...>) noexcept {
+		static const Handler table[] = { &TypedReactor::call<Ts>... };
+		return table;
+	}
+};
+
+#endif
\ No newline at end of file
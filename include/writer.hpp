@@ -1,8 +1,91 @@
 #ifndef WRITER_HPP
 #define WRITER_HPP
 
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// binary serializer appending to a caller-owned buffer
+// integers are little-endian, strings and blobs are prefixed by a u32 length
+// reusing the buffer avoids allocations once it reached its working size
 class Writer {
-	
+public:
+	explicit Writer(std::string& buffer) noexcept: _buffer(buffer) {}
+	Writer(const Writer&) = delete;
+	Writer& operator=(const Writer&) = delete;
+	std::string& buffer() noexcept {
+		return _buffer;
+	}
+	size_t size() const noexcept {
+		return _buffer.size();
+	}
+	void write_bool(bool value) {
+		write_u8(value ? 1 : 0);
+	}
+	void write_u8(uint8_t value) {
+		_buffer.push_back(static_cast<char>(value));
+	}
+	void write_u16(uint16_t value) {
+		write_le(value, 2);
+	}
+	void write_u32(uint32_t value) {
+		write_le(value, 4);
+	}
+	void write_u64(uint64_t value) {
+		write_le(value, 8);
+	}
+	void write_i32(int32_t value) {
+		write_le(static_cast<uint32_t>(value), 4);
+	}
+	void write_i64(int64_t value) {
+		write_le(static_cast<uint64_t>(value), 8);
+	}
+	void write_f64(double value) {
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		write_le(bits, 8);
+	}
+	void write_bytes(const void* data, size_t size) {
+		write_u32(static_cast<uint32_t>(size));
+		_buffer.append(static_cast<const char*>(data), size);
+	}
+	void write_string(const std::string& value) {
+		write_bytes(value.data(), value.size());
+	}
+	void write_string(const char* value) {
+		write_bytes(value, strlen(value));
+	}
+	// u32 length prefix written once the payload is known
+	size_t begin_block() {
+		const size_t offset = _buffer.size();
+		write_u32(0);
+		return offset;
+	}
+	void end_block(size_t offset) noexcept {
+		const uint64_t size = _buffer.size() - offset - 4;
+		for(unsigned i = 0; i < 4; ++i) {
+			_buffer[offset + i] = static_cast<char>(size >> (i * 8));
+		}
+	}
+	// type followed by the length-prefixed dump of the event
+	template<typename T>
+	void write_event(const T& event) {
+		write_u32(event.type);
+		const size_t block = begin_block();
+		event.dump(*this);
+		end_block(block);
+	}
+private:
+	void write_le(uint64_t value, unsigned size) {
+		char bytes[8];
+		for(unsigned i = 0; i < size; ++i) {
+			bytes[i] = static_cast<char>(value >> (i * 8));
+		}
+		_buffer.append(bytes, size);
+	}
+
+	std::string& _buffer;
 };
 
 #endif
\ No newline at end of file
@@ -2,31 +2,63 @@
 #define LOG_REACTOR_HPP
 
 #include <cstdio>
+#include <string>
 #include "common-events.hpp"
-#include "reactor.hpp"
+#include "log-sink.hpp"
+#include "typed-reactor.hpp"
 
-class LogReactor: public Reactor {
+// writes the lines of a batch of events to the sink at once
+// output is held until flush_size bytes (0 flushes every batch), an EvtFlush,
+// or, with a flush interval, flush_interval us after it was written
+class LogReactor: public TypedReactor<LogReactor, EvtLog, EvtFlush, EvtExit> {
+	friend Typed;
 public:
-	explicit LogReactor(SelfPtr self): _self(self) {
-		setbuf(stdout, nullptr);
-	}
+	explicit LogReactor(SelfPtr self, LogSink&& sink = LogSink(), size_t flush_size = 0, uint64_t flush_interval = 0): _self(self), _sink(std::move(sink)), _flush_size(flush_size), _flush_interval(flush_interval) {}
 	void dump(Writer& writer) const override {}
-	void react(const EventPtr& event, uint64_t timestamp) override {
-		switch(event->type) {
-			case EvtLog::TYPE:
-				printf("%s (%llu)\n", event->as<EvtLog>().text, (long long unsigned int)timestamp);
-				break;
-			case EvtExit::TYPE:
-				printf("[L] exit (%llu)\n", (long long unsigned int)timestamp);
-				_self->reset();
-				break;
-			default:
-				printf("[L] unknown<%u> (%llu)\n", event->type, (long long unsigned int)timestamp);
-				break;
+	void after_batch() override {
+		if(_sink.size() == 0) {
+			return;
+		}
+		if(_sink.size() >= _flush_size) {
+			_sink.flush();
+		} else if(_flush_interval > 0 && !_flush_pending) {
+			_flush_pending = true;
+			_self->send(
+				Event::make<EvtFlush>(),
+				_flush_interval
+			);
 		}
 	}
 private:
+	void on(const EvtLog& event, uint64_t timestamp) {
+		event.print(_sink.buffer());
+		line_end(timestamp);
+	}
+	void on(const EvtFlush& event, uint64_t timestamp) {
+		_flush_pending = false;
+		_sink.flush();
+	}
+	void on(const EvtExit& event, uint64_t timestamp) {
+		_sink.buffer().append("[L] exit");
+		line_end(timestamp);
+		_sink.flush();
+		_self->reset();
+	}
+	void on_unknown(const EventPtr& event, uint64_t timestamp) {
+		_sink.buffer().append("[L] unknown<").append(std::to_string(event->type)).append(">");
+		line_end(timestamp);
+	}
+	void line_end(uint64_t timestamp) {
+		char text[32];
+		const int size = snprintf(text, sizeof(text), " (%llu)\n", (long long unsigned int)timestamp);
+		_sink.buffer().append(text, size);
+	}
+
 	SelfPtr _self;
+	LogSink _sink;
+	const size_t _flush_size;
+	const uint64_t _flush_interval;
+	bool _flush_pending = false;
 };
 
 
@@ -0,0 +1,108 @@
+#ifndef LOG_SINK_HPP
+#define LOG_SINK_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include "uv.hpp"
+
+// buffered output of a log, written with one write() per flush
+// file sinks rotate to path.1 .. path.<max_files> once max_file_size is written
+class LogSink {
+public:
+	// standard output
+	LogSink() noexcept: _fd(STDOUT_FILENO) {}
+	// appends to the file at path, max_file_size 0 never rotates
+	explicit LogSink(std::string path, size_t max_file_size = 0, unsigned max_files = 1): _path(std::move(path)), _max_file_size(max_file_size), _max_files(max_files) {
+		open();
+	}
+	LogSink(LogSink&& other) noexcept: _buffer(std::move(other._buffer)), _path(std::move(other._path)), _fd(other._fd), _max_file_size(other._max_file_size), _max_files(other._max_files), _file_size(other._file_size) {
+		other._fd = -1;
+	}
+	LogSink(const LogSink&) = delete;
+	LogSink& operator=(const LogSink&) = delete;
+	~LogSink() noexcept {
+		try {
+			flush();
+		} catch(...) {
+		}
+		close();
+	}
+	// pending output, append to it and flush() when done
+	std::string& buffer() noexcept {
+		return _buffer;
+	}
+	size_t size() const noexcept {
+		return _buffer.size();
+	}
+	void flush() {
+		if(_buffer.empty() || _fd < 0) {
+			return;
+		}
+		if(_fd == STDOUT_FILENO) {
+			fflush(stdout); // keeps the order with stdio output
+		}
+		const char* data = _buffer.data();
+		size_t left = _buffer.size();
+		while(left > 0) {
+			const ssize_t written = ::write(_fd, data, left);
+			if(written < 0) {
+				if(errno == EINTR) {
+					continue;
+				}
+				_buffer.clear();
+				throw ExceptionUV(uv_translate_sys_error(errno));
+			}
+			data += written;
+			left -= written;
+		}
+		_file_size += _buffer.size();
+		_buffer.clear();
+		if(_max_file_size > 0 && _file_size >= _max_file_size) {
+			rotate();
+		}
+	}
+private:
+	void open() {
+		_fd = ::open(_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if(_fd < 0) {
+			throw ExceptionUV(uv_translate_sys_error(errno));
+		}
+		const off_t size = ::lseek(_fd, 0, SEEK_END);
+		_file_size = size > 0 ? static_cast<size_t>(size) : 0;
+	}
+	void close() noexcept {
+		if(_fd >= 0 && _fd != STDOUT_FILENO) {
+			::close(_fd);
+		}
+		_fd = -1;
+	}
+	// path.<n-1> -> path.<n>, ..., path -> path.1
+	void rotate() {
+		close();
+		for(unsigned i = _max_files; i > 1; --i) {
+			::rename(numbered(i - 1).c_str(), numbered(i).c_str());
+		}
+		if(_max_files > 0) {
+			::rename(_path.c_str(), numbered(1).c_str());
+		} else {
+			::unlink(_path.c_str());
+		}
+		open();
+	}
+	std::string numbered(unsigned n) const {
+		return _path + "." + std::to_string(n);
+	}
+
+	std::string _buffer;
+	std::string _path;
+	int _fd;
+	size_t _max_file_size = 0;
+	unsigned _max_files = 0;
+	size_t _file_size = 0;
+};
+
+#endif
\ No newline at end of file
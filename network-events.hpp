@@ -7,7 +7,11 @@
 class EvtListen: public EventType<0x745EFDA1> {
 public:
 	explicit EvtListen(std::string&& _host, uint16_t _port, uint16_t _max_peers): host(std::move(_host)), port(_port), max_peers(_max_peers) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(host);
+		writer.write_u16(port);
+		writer.write_u16(max_peers);
+	}
 	std::string host;
 	uint16_t port;
 	uint16_t max_peers;
@@ -16,7 +20,10 @@ public:
 class EvtConnect: public EventType<0x16A49E5A> {
 public:
 	explicit EvtConnect(std::string&& _host, uint16_t _port): host(std::move(_host)), port(_port) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_string(host);
+		writer.write_u16(port);
+	}
 	std::string host;
 	uint16_t port;
 };
@@ -24,37 +31,53 @@ public:
 class EvtSend: public EventType<0x7C73679C> {
 public:
 	explicit EvtSend(uint32_t _dst, std::string&& _buf, bool _reliable): dst(_dst), buf(std::move(_buf)), reliable(_reliable) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u32(dst);
+		writer.write_string(buf);
+		writer.write_bool(reliable);
+	}
+	virtual bool droppable() const noexcept override {
+		return !reliable;
+	}
 	uint32_t dst;
 	std::string buf;
 	bool reliable;
 };
 
-class EvtKick: public EventType<0xC5D58254> {
+class EvtKick: public InlineEventType<0xC5D58254, EvtKick> {
 public:
 	explicit EvtKick(uint32_t _dst): dst(_dst) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u32(dst);
+	}
 	uint32_t dst;
 };
 
-class EvtConnected: public EventType<0x446F3565> {
+class EvtConnected: public InlineEventType<0x446F3565, EvtConnected> {
 public:
 	explicit EvtConnected(uint16_t _id): src(_id) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u16(src);
+	}
 	uint16_t src;
 };
 
-class EvtDisconnected: public EventType<0xBF733E42> {
+class EvtDisconnected: public InlineEventType<0xBF733E42, EvtDisconnected> {
 public:
 	explicit EvtDisconnected(uint16_t _id): src(_id) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u16(src);
+	}
 	uint16_t src;
 };
 
 class EvtReceived: public EventType<0xCFB8E7BF> {
 public:
 	explicit EvtReceived(uint16_t _id, std::string&& _data): src(_id), data(std::move(_data)) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_u16(src);
+		writer.write_string(data);
+	}
 	uint16_t src;
 	std::string data;
 };
@@ -2,7 +2,7 @@
 #define SQLITE_REACTOR_HPP
 
 #include <sqlite3.h>
-#include "reactor.hpp"
+#include "typed-reactor.hpp"
 #include "common-events.hpp"
 #include "database-events.hpp"
 
@@ -145,36 +145,53 @@ private:
 	sqlite3_stmt* _stmt;
 };
 
-class SqliteReactor: public Reactor {
+class SqliteReactor: public TypedReactor<SqliteReactor, EvtPut, EvtGet, EvtExit> {
+	friend Typed;
 public:
-	explicit SqliteReactor(SelfPtr self, ActorPtr observer, ActorPtr logger): _self(self), _observer(observer), _logger(logger), _db(":memory:", "create table test(key varchar(256), value varchar(256));"), _stmt_put(_db, "insert into test (key, value) values (?, ?);"), _stmt_get(_db, "select value from test where key=?;") {
+	explicit SqliteReactor(SelfPtr self, ActorPtr observer, ActorPtr logger): _self(self), _observer(observer), _logger(logger), _db(":memory:", "create table test(key varchar(256) check(length(key) > 0), value varchar(256));"), _stmt_put(_db, "insert into test (key, value) values (?, ?);"), _stmt_get(_db, "select value from test where key=?;") {
 	}
 	void dump(Writer& writer) const override {}
-	void react(const EventPtr& event, uint64_t timestamp) override {
-		switch(event->type) {
-			case EvtPut::TYPE:
-				on_put(event->as<EvtPut>(), timestamp);
-				break;
-			case EvtGet::TYPE:
-				on_get(event->as<EvtGet>(), timestamp);
-				break;
-			case EvtExit::TYPE:
-				_self->reset();
-				break;
-			default:
-				break;
+	// consecutive puts share one transaction
+	// a failing put keeps the ones before it and stays with the rest in batch
+	void react_batch(Batch& batch) override {
+		while(!batch.empty()) {
+			if(batch.front().first->type != EvtPut::TYPE || batch.size() < 2) {
+				react(batch.front().first, batch.front().second); // can throw
+				batch.pop_front();
+				continue;
+			}
+			const EventPair* run = batch.position();
+			_db.exec("begin;");
+			try {
+				while(!batch.empty() && batch.front().first->type == EvtPut::TYPE) {
+					on(batch.front().first->as<EvtPut>(), batch.front().second);
+					batch.pop_front();
+				}
+			} catch(...) {
+				if(!sqlite3_get_autocommit(_db.raw())) {
+					// only the failing statement was undone
+					_db.exec("commit;");
+				} else {
+					// sqlite rolled back the whole transaction
+					for(const EventPair* itr = run; itr != batch.position(); ++itr) {
+						insert(itr->first->as<EvtPut>());
+					}
+				}
+				throw;
+			}
+			_db.exec("commit;");
 		}
 	}
 private:
-	void on_put(const EvtPut& event, uint32_t timestamp) {
+	void on(const EvtPut& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[D] put %s: %s", event.key.c_str(), event.value.c_str())
+			Event::make<EvtLog>("[D] put %s: %s"_log, event.key.c_str(), event.value.c_str())
 		);
-		_stmt_put.bind(event.key, event.value).row();
+		insert(event);
 	}
-	void on_get(const EvtGet& event, uint32_t timestamp) {
+	void on(const EvtGet& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[D] get %s", event.key.c_str())
+			Event::make<EvtLog>("[D] get %s"_log, event.key.c_str())
 		);
 		const char* value;
 		std::string result;
@@ -183,7 +200,7 @@ private:
 			result = value;
 		}
 		_logger->send(
-			Event::make<EvtLog>("\tresult: %s", result.c_str())
+			Event::make<EvtLog>("\tresult: %s"_log, result.c_str())
 		);
 		_observer->send(
 			Event::make<EvtResult>(
@@ -192,6 +209,12 @@ private:
 			)
 		);
 	}
+	void on(const EvtExit& event, uint64_t timestamp) {
+		_self->reset();
+	}
+	void insert(const EvtPut& event) {
+		_stmt_put.bind(event.key, event.value).row();
+	}
 	
 	SelfPtr _self;
 	ActorPtr _observer;
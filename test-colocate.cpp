@@ -0,0 +1,107 @@
+#include "context-pool.hpp"
+#include "common-events.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+enum {
+	NUM_ROUND_TRIPS = 10000,
+	SIDE_PERIOD = 100, // one send to the side peer every SIDE_PERIOD events
+};
+
+std::atomic<unsigned> finished{0};
+
+// chats with its peer, now and then tells its side peer too
+class ChatReactor: public Reactor {
+public:
+	explicit ChatReactor(SelfPtr self, ActorPtr peer, ActorPtr side, unsigned count): _self(self), _peer(peer), _side(side), _count(count) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		switch(event->type) {
+			case EvtUpdate::TYPE:
+				if(_count == 0) {
+					break;
+				}
+				if(--_count == 0) {
+					finished.fetch_add(1);
+				}
+				if(_side && _count % SIDE_PERIOD == 0) {
+					_side->send(
+						Event::make<EvtUpdate>()
+					);
+				}
+				_peer->send(event);
+				break;
+			case EvtExit::TYPE:
+				_self->reset();
+				break;
+			default:
+				break;
+		}
+	}
+private:
+	SelfPtr _self;
+	ActorPtr _peer;
+	ActorPtr _side;
+	unsigned _count;
+};
+
+class IdleReactor: public Reactor {
+public:
+	explicit IdleReactor(SelfPtr self): _self(self) {}
+	void dump(Writer& writer) const override {}
+	void react(const EventPtr& event, uint64_t timestamp) override {
+		if(event->type == EvtExit::TYPE) {
+			_self->reset();
+		}
+	}
+private:
+	SelfPtr _self;
+};
+
+// a and b chat on one context, b sometimes sends to c on the other:
+// colocate() must bring c to them, not split a and b
+int main() {
+	ContextPool pool(2);
+	pool.set_affinity_profile(true);
+	ActorUV::SharedPtr a = pool.spawn();
+	ActorUV::SharedPtr c = pool.spawn();
+	ActorUV::SharedPtr b = pool.spawn();
+	if(a->home() != b->home() || a->home() == c->home()) {
+		printf("unexpected initial placement\n");
+		return 1;
+	}
+	a->reset(
+		Reactor::make<ChatReactor>(a, b, nullptr, NUM_ROUND_TRIPS)
+	);
+	b->reset(
+		Reactor::make<ChatReactor>(b, a, c, NUM_ROUND_TRIPS)
+	);
+	c->reset(
+		Reactor::make<IdleReactor>(c)
+	);
+	a->send(
+		Event::make<EvtUpdate>()
+	);
+	pool.exec();
+	while(finished.load() < 2) {
+		uv_sleep(1);
+	}
+	const ContextPool::Colocation colocation = pool.colocate();
+	for(ActorUV* actor : {a.get(), b.get(), c.get()}) {
+		actor->send(
+			Event::make<EvtExit>()
+		);
+	}
+	pool.wait();
+	printf("colocate() moved %u actors\n", (unsigned)colocation.moved);
+	if(a->home() != b->home()) {
+		printf("a and b were split\n");
+		return 1;
+	}
+	if(c->home() != a->home()) {
+		printf("c was not moved next to a and b\n");
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
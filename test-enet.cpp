@@ -1,14 +1,15 @@
-#include "context-uv.hpp"
+#include "scheduler-uv.hpp"
 #include "enet-reactor-auto.hpp"
 #include "enet-reactor-uv.hpp"
 #include "log-reactor.hpp"
+#include "reader.hpp"
 
 #include <ctime>
 #include <cstring>
 
 class TimeReactor: public Reactor {
 	enum {
-		UPDATE_TIME = 1000,
+		UPDATE_TIME = 1000000, // us
 	};
 public:
 	explicit TimeReactor(SelfPtr self, ActorPtr client, ActorPtr logger): _self(self), _client(client), _logger(logger) {}
@@ -26,7 +27,6 @@ public:
 				break;
 			case EvtUpdate::TYPE:
 				on_update(event->as<EvtUpdate>(), timestamp);
-				_self->send(event, UPDATE_TIME);
 				break;
 			default:
 				break;
@@ -35,35 +35,44 @@ public:
 private:
 	void on_connect(const EvtConnected& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[C] connected src=%u t=%llu", event.src, (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[C] connected src=%u t=%llu"_log, event.src, (long long unsigned int)timestamp)
 		);
 		_self->send(
 			Event::make<EvtUpdate>()
 		);
+		_self->send_every(
+			Event::make<EvtUpdate>(),
+			UPDATE_TIME
+		);
 		_id = event.src;
 	}
 	void on_disconnect(const EvtDisconnected& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[C] disconnected src=%u t=%llu", event.src, (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[C] disconnected src=%u t=%llu"_log, event.src, (long long unsigned int)timestamp)
 		);
 	}
 	void on_received(const EvtReceived& event, uint64_t timestamp) {
-		const time_t* t = reinterpret_cast<const time_t*>(event.data.c_str());
-		char* s = ctime(t);
+		Reader reader(event.data);
+		const time_t t = static_cast<time_t>(reader.read_i64());
+		if(!reader.good()) {
+			return;
+		}
+		char* s = ctime(&t);
 		char* n = strchr(s, '\n');
 		if(n != nullptr) {
 			*n = '\0';
 		}
 		_logger->send(
-			Event::make<EvtLog>("[C] received src=%u data=\"%s\" t=%llu", event.src, s, (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[C] received src=%u data=\"%s\" t=%llu"_log, event.src, s, (long long unsigned int)timestamp)
 		);
 	}
 	void on_update(const EvtUpdate& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[C] update t=%llu", (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[C] update t=%llu"_log, (long long unsigned int)timestamp)
 		);
-		time_t t = time(nullptr);
-		std::string data(reinterpret_cast<const char*>(&t), sizeof(t));
+		std::string data;
+		Writer writer(data);
+		writer.write_i64(static_cast<int64_t>(time(nullptr)));
 		_client->send(
 			Event::make<EvtSend>(_id, std::move(data), true)
 		);
@@ -97,17 +106,17 @@ public:
 private:
 	void on_connect(const EvtConnected& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[S] connected src=%u t=%llu", event.src, (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[S] connected src=%u t=%llu"_log, event.src, (long long unsigned int)timestamp)
 		);
 	}
 	void on_disconnect(const EvtDisconnected& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[S] disconnected src=%u t=%llu", event.src, (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[S] disconnected src=%u t=%llu"_log, event.src, (long long unsigned int)timestamp)
 		);
 	}
 	void on_received(const EvtReceived& event, uint64_t timestamp) {
 		_logger->send(
-			Event::make<EvtLog>("[S] received src=%u size=%u t=%llu", event.src, event.data.size(), (long long unsigned int)timestamp)
+			Event::make<EvtLog>("[S] received src=%u size=%u t=%llu"_log, event.src, event.data.size(), (long long unsigned int)timestamp)
 		);
 		_server->send(
 			Event::make<EvtSend>(event.src, std::string(event.data), true)
@@ -128,12 +137,11 @@ enum {
 int main() {
 	printf("initializing\n");
 	
-	ContextUV contexts[NUM_THREADS];
-	unsigned idx = 0;
+	SchedulerUV scheduler(NUM_THREADS);
 	
-	ActorSelf::SharedPtr logger = contexts[(idx++) % NUM_THREADS].spawn();
-	ActorUV::SharedPtr enet_server = contexts[(idx++) % NUM_THREADS].spawn();
-	ActorSelf::SharedPtr echo_server = contexts[(idx++) % NUM_THREADS].spawn();
+	ActorSelf::SharedPtr logger = scheduler.spawn();
+	ActorUV::SharedPtr enet_server = scheduler.spawn();
+	ActorUV::SharedPtr echo_server = scheduler.spawn();
 	std::vector<ActorSelf::SharedPtr> enet_clients;
 	std::vector<ActorSelf::SharedPtr> time_clients;
 	
@@ -143,16 +151,18 @@ int main() {
 	enet_server->reset(
 		Reactor::make<ENetReactorUV>(enet_server, echo_server)
 	);
+	echo_server->set_outbox(true);
 	echo_server->reset(
 		Reactor::make<EchoReactor>(echo_server, enet_server, logger)
 	);
 	
 	for(unsigned i = 0; i < NUM_CLIENTS; ++i) {
-		ActorUV::SharedPtr enet_client = contexts[(idx++) % NUM_THREADS].spawn();
-		ActorSelf::SharedPtr time_client = contexts[(idx++) % NUM_THREADS].spawn();
+		ActorUV::SharedPtr enet_client = scheduler.spawn();
+		ActorUV::SharedPtr time_client = scheduler.spawn();
 		enet_client->reset(
 			Reactor::make<ENetReactorUV>(enet_client, time_client)
 		);
+		time_client->set_outbox(true);
 		time_client->reset(
 			Reactor::make<TimeReactor>(time_client, enet_client, logger)
 		);
@@ -170,12 +180,8 @@ int main() {
 		Event::make<EvtListen>("localhost", APP_PORT, NUM_CLIENTS)
 	);
 	
-	for(auto& ctx : contexts) {
-		ctx.exec();
-	}
-	for(auto& ctx : contexts) {
-		ctx.wait();
-	}
+	scheduler.exec();
+	scheduler.wait();
 	
 	return 0;
 }
\ No newline at end of file
@@ -2,12 +2,54 @@
 #include "sqlite-reactor.hpp"
 #include "log-reactor.hpp"
 #include "fake-actor.hpp"
+#include "stateful.hpp"
 
 enum {
 	NUM_THREADS = 8,
 };
 
+// keeps the results sent to it
+class ResultActor: public Actor {
+public:
+	Token send(EventPtr event, uint64_t delay) override {
+		if(event->type == EvtResult::TYPE) {
+			results.push_back(event->as<EvtResult>().value);
+		}
+		return Token();
+	}
+	std::vector<std::string> results;
+};
+
+// a put failing in the middle of a batch keeps the puts before it
+bool check_failed_put() {
+	std::shared_ptr<ResultActor> observer = std::make_shared<ResultActor>();
+	Stateful stateful;
+	stateful.set(
+		Reactor::make<SqliteReactor>(nullptr, observer, std::make_shared<FakeActor>())
+	);
+	Queue::EventVector events;
+	events.emplace_back(Event::make<EvtPut>("a", "1"), 0);
+	events.emplace_back(Event::make<EvtPut>("", "2"), 0);
+	events.emplace_back(Event::make<EvtPut>("c", "3"), 0);
+	try {
+		stateful.trigger(events);
+		return false;
+	} catch(const SqliteException& e) {
+		printf("put failed: %s\n", e.what());
+	}
+	events.clear();
+	events.emplace_back(Event::make<EvtGet>("a"), 0);
+	events.emplace_back(Event::make<EvtGet>("c"), 0);
+	stateful.trigger(events);
+	return observer->results == std::vector<std::string>{"1", ""};
+}
+
 int main() {
+	if(!check_failed_put()) {
+		printf("failed put lost the puts before it\n");
+		return 1;
+	}
+	
 	printf("initializing\n");
 	
 	std::vector<ContextUV> contexts(NUM_THREADS);
@@ -34,10 +76,10 @@ int main() {
 		Event::make<EvtGet>("bar")
 	);
 	database->send(
-		Event::make<EvtExit>(), 100
+		Event::make<EvtExit>(), 100000
 	);
 	logger->send(
-		Event::make<EvtExit>(), 100
+		Event::make<EvtExit>(), 100000
 	);
 	
 	for(auto& ctx : contexts) {
@@ -1,11 +1,14 @@
 #include "context-uv.hpp"
 #include "common-events.hpp"
 #include "log-reactor.hpp"
+#include "typed-reactor.hpp"
 
 class EvtTest: public EventType<1> {
 public:
 	explicit EvtTest(int _e): e(_e) {}
-	virtual void dump(Writer& writer) const override {}
+	virtual void dump(Writer& writer) const override {
+		writer.write_i32(e);
+	}
 	int e;
 };
 
@@ -14,41 +17,39 @@ public:
 	virtual void dump(Writer& writer) const override {}
 };
 
-class ReactorTest: public Reactor {
+class ReactorTest: public TypedReactor<ReactorTest, EvtTest, EvtExit, EvtReset> {
+	friend Typed;
 public:
 	explicit ReactorTest(SelfPtr self, ActorPtr logger, int n): _self(self), _logger(logger), _n(n) {}
 	void dump(Writer& writer) const override {}
-	void react(const EventPtr& event, uint64_t timestamp) override {
-		switch(event->type) {
-			case EvtTest::TYPE:
-				_logger->send(
-					std::make_shared<EvtLog>("%i: %i (%llu)", _n, event->as<EvtTest>().e, (long long unsigned int)timestamp)
-				);
-				break;
-			case EvtExit::TYPE:
-				_logger->send(
-					std::make_shared<EvtLog>("%i: exit (%llu)", _n, (long long unsigned int)timestamp)
-				);
-				_self->reset();
-				break;
-			case EvtReset::TYPE:
-				_logger->send(
-					std::make_shared<EvtLog>("%i: reset (%llu)", _n, (long long unsigned int)timestamp)
-				);
-				_self->reset(
-					std::unique_ptr<Reactor>(
-						new ReactorTest(_self, _logger, _n)
-					)
-				);
-				break;
-			default:
-				_logger->send(
-					std::make_shared<EvtLog>("%i: unknown<%u> (%llu)", _n, event->type, (long long unsigned int)timestamp)
-				);
-				break;
-		}
-	}
 private:
+	void on(const EvtTest& event, uint64_t timestamp) {
+		_logger->send(
+			Event::make<EvtLog>("%i: %i (%llu)"_log, _n, event.e, (long long unsigned int)timestamp)
+		);
+	}
+	void on(const EvtExit& event, uint64_t timestamp) {
+		_logger->send(
+			Event::make<EvtLog>("%i: exit (%llu)"_log, _n, (long long unsigned int)timestamp)
+		);
+		_self->reset();
+	}
+	void on(const EvtReset& event, uint64_t timestamp) {
+		_logger->send(
+			Event::make<EvtLog>("%i: reset (%llu)"_log, _n, (long long unsigned int)timestamp)
+		);
+		_self->reset(
+			std::unique_ptr<Reactor>(
+				new ReactorTest(_self, _logger, _n)
+			)
+		);
+	}
+	void on_unknown(const EventPtr& event, uint64_t timestamp) {
+		_logger->send(
+			Event::make<EvtLog>("%i: unknown<%u> (%llu)"_log, _n, event->type, (long long unsigned int)timestamp)
+		);
+	}
+
 	SelfPtr _self;
 	ActorPtr _logger;
 	int _n;
@@ -58,7 +59,7 @@ enum {
 	NUM_THREADS = 4,
 	NUM_ACTORS = 7,
 	NUM_EVENTS = 10,
-	TIME_STEP = 20,
+	TIME_STEP = 20000, // us
 };
 
 int main() {
@@ -75,7 +76,7 @@ int main() {
 		)
 	);
 	logger->send(
-		std::make_shared<EvtExit>(),
+		Event::make<EvtExit>(),
 		(NUM_EVENTS + 1) * TIME_STEP
 	);
 	
@@ -94,23 +95,26 @@ int main() {
 		actors.push_back(actor);
 	}
 	
+	std::vector<Actor::EventDelay> batch;
 	for(unsigned i = 0; i < NUM_ACTORS; ++i) {
+		batch.clear();
 		for(unsigned e = 0; e < NUM_EVENTS; ++e) {
-			actors[i]->send(
-				std::make_shared<EvtTest>(e),
+			batch.emplace_back(
+				Event::make<EvtTest>(e),
 				e * TIME_STEP
 			);
 			if(i == e) {
-				actors[i]->send(
-					std::make_shared<EvtReset>(),
+				batch.emplace_back(
+					Event::make<EvtReset>(),
 					e * TIME_STEP
 				);
 			}
 		}
-		actors[i]->send(
-			std::make_shared<EvtExit>(),
+		batch.emplace_back(
+			Event::make<EvtExit>(),
 			(NUM_EVENTS) * TIME_STEP
 		);
+		actors[i]->send_batch(batch);
 	}
 	
 	for(auto& ctx : contexts) {